@@ -0,0 +1,41 @@
+/**
+ * Module interface unit of the `invoke_forall` template.
+ *
+ * Exports `invoke_forall`, `protect_arg` and the result traits of
+ * `invoke_forall.h`, together with the variants from the headers it pulls in:
+ * `invoke_forall_expected`, `invoke_forall_scan` (with `scan_init`),
+ * `invoke_forall_common`, `invoke_forall_span`, `invoke_forall_compact`,
+ * `invoke_forall_packed`, `invoke_forall_grouped` and
+ * `invoke_forall_inplace`, with their result and tag types. The `detail`
+ * namespace is not exported and stays internal to the module. Translation
+ * units that do not use modules can keep including the headers directly.
+ */
+
+module;
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <expected>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+export module invoke_forall;
+
+#define INVOKE_FORALL_EXPORT export
+#include "invoke_forall.h"
+#include "invoke_forall_common.h"
+#include "invoke_forall_compact.h"
+#include "invoke_forall_expected.h"
+#include "invoke_forall_grouped.h"
+#include "invoke_forall_inplace.h"
+#include "invoke_forall_packed.h"
+#include "invoke_forall_scan.h"
+#include "invoke_forall_span.h"
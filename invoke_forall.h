@@ -11,6 +11,14 @@
  *
  * The module also provides the `protect_arg()` function that makes
  * `invoke_forall` treat protected Gettable arguments as regular arguments.
+ *
+ * `invoke_forall` is `noexcept` exactly when it cannot throw, which the
+ * traits `is_nothrow_invoke_forall_v` and
+ * `is_trivially_copyable_invoke_forall_v` expose for given argument types.
+ *
+ * Variants with other result shapes or error handling live in their own
+ * `invoke_forall_*.h` headers, so code that only needs `invoke_forall` does
+ * not pay for them.
  */
 
 #ifndef INVOKE_FORALL_H
@@ -25,6 +33,14 @@
 #include <utility>
 #include <variant>
 
+/**
+ * Expands to `export` when the header is compiled as part of the
+ * `invoke_forall` module interface unit, and to nothing otherwise.
+ */
+#ifndef INVOKE_FORALL_EXPORT
+#define INVOKE_FORALL_EXPORT
+#endif
+
 namespace detail
 {
 
@@ -63,19 +79,101 @@ concept TupleLike = HasTupleSizeDerivedFromIntegralConstant<T>;
 
 /** Satisfied if `std::get<I>(t)` is valid. */
 template <std::size_t I, typename T>
-concept HasGet = requires(T t) { (void)std::get<I>(t); };
+concept HasStdGet = requires(T t) { (void)std::get<I>(t); };
+
+/** Satisfied if `t.get<I>()` is valid. */
+template <std::size_t I, typename T>
+concept HasMemberGet = requires(T t) { (void)t.template get<I>(); };
+
+namespace adl
+{
+
+using std::get;
+
+/** Satisfied if `get<I>(t)` is valid, looked up like in structured bindings. */
+template <std::size_t I, typename T>
+concept HasAdlGet = requires(T t) { (void)get<I>(t); };
+
+template <std::size_t I, typename T>
+constexpr decltype(auto) adl_get(T&& t) noexcept(
+    noexcept(get<I>(std::forward<T>(t))))
+{
+    return get<I>(std::forward<T>(t));
+}
+
+} /* namespace adl */
+
+/**
+ * Satisfied if the `I`-th element of `t` is accessible through
+ * `std::get<I>(t)`, or like in a structured binding: through a member
+ * `t.get<I>()` or a `get<I>(t)` found by argument-dependent lookup.
+ */
+template <std::size_t I, typename T>
+concept HasGet =
+    HasStdGet<I, T> || HasMemberGet<I, T> || adl::HasAdlGet<I, T>;
+
+/**
+ * Checks `HasGet<I, T>` for all indices `I` in `Is` with a single fold.
+ *
+ * Only instantiated for user-defined tuple-like types, the standard ones
+ * are handled by the specializations of `is_gettable` below.
+ */
+template <typename T, typename Is>
+struct has_all_gets : std::false_type {};
+
+template <typename T, std::size_t... Is>
+struct has_all_gets<T, std::index_sequence<Is...>>
+    : std::bool_constant<(... && HasGet<Is, T>)> {};
+
+/**
+ * Defers building the index sequence until `T` is known to be TupleLike,
+ * so that `std::tuple_size_v<T>` is never named for other types.
+ */
+template <typename T>
+struct has_all_gets_lazy
+    : has_all_gets<T, std::make_index_sequence<
+                          std::tuple_size_v<std::remove_cvref_t<T>>>> {};
+
+/**
+ * Caches whether `T` (with references stripped, but cv-qualifiers kept) is
+ * Gettable. Every later check of the same type is a single lookup.
+ */
+template <typename T>
+struct is_gettable
+    : std::conjunction<std::bool_constant<TupleLike<T> && !Protected<T>>,
+                       has_all_gets_lazy<T>> {};
+
+template <typename T, std::size_t N>
+struct is_gettable<std::array<T, N>> : std::true_type {};
+
+template <typename T, std::size_t N>
+struct is_gettable<const std::array<T, N>> : std::true_type {};
+
+template <typename... Ts>
+struct is_gettable<std::tuple<Ts...>> : std::true_type {};
+
+template <typename... Ts>
+struct is_gettable<const std::tuple<Ts...>> : std::true_type {};
+
+template <typename T, typename U>
+struct is_gettable<std::pair<T, U>> : std::true_type {};
+
+template <typename T, typename U>
+struct is_gettable<const std::pair<T, U>> : std::true_type {};
+
+template <typename T>
+struct is_gettable<protected_arg<T>> : std::false_type {};
+
+template <typename T>
+struct is_gettable<const protected_arg<T>> : std::false_type {};
 
 /**
  * Satisfied if:
  * - `T` is TupleLike and not protected by `protect_arg()`, and
- * - `std::get<i>(t)` is valid for all indices `0 ≤ i < std::tuple_size_v<T>`.
+ * - `HasGet<i, T>` for all indices `0 ≤ i < std::tuple_size_v<T>`.
  */
 template <typename T>
-concept Gettable =
-    TupleLike<T> && !Protected<T> &&
-    []<std::size_t... Is>(std::index_sequence<Is...>) {
-        return (... && HasGet<Is, T>);
-    }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<T>>>{});
+concept Gettable = is_gettable<std::remove_reference_t<T>>::value;
 
 template <typename... Args>
 concept NoneGettable = (... && !Gettable<Args>);
@@ -83,20 +181,39 @@ concept NoneGettable = (... && !Gettable<Args>);
 template <typename... Args>
 concept NonEmpty = sizeof...(Args) > 0;
 
+/** Arity of `T` if it is Gettable, `0` otherwise. */
+template <typename T>
+struct gettable_arity : std::integral_constant<std::size_t, 0> {};
+
+template <Gettable T>
+struct gettable_arity<T>
+    : std::integral_constant<std::size_t,
+                             std::tuple_size_v<std::remove_cvref_t<T>>> {};
+
+/**
+ * The arity of the first Gettable argument, or `0` if none are found.
+ * Computed once per argument pack with a linear scan instead of recursion.
+ */
+template <typename... Args>
+inline constexpr std::size_t first_arity_v = [] {
+    constexpr bool gettable[] = { Gettable<Args>..., true };
+    constexpr std::size_t arity[] = { gettable_arity<Args>::value..., 0 };
+
+    std::size_t i = 0;
+    while (!gettable[i]) {
+        ++i;
+    }
+    return arity[i];
+}();
+
 /**
  * Returns the arity of the first Gettable argument,
  * or `0` if none are found.
  */
-template <typename T, typename... Args>
+template <typename... Args>
 constexpr std::size_t first_arity_or_zero()
 {
-    if constexpr (Gettable<T>) {
-        return std::tuple_size_v<std::remove_cvref_t<T>>;
-    } else if constexpr (NonEmpty<Args...>) {
-        return first_arity_or_zero<Args...>();
-    } else {
-        return 0;
-    }
+    return first_arity_v<Args...>;
 }
 
 /**
@@ -105,8 +222,7 @@ constexpr std::size_t first_arity_or_zero()
  * - has arity equal to `A`.
  */
 template <std::size_t A, typename T>
-concept HasArity =
-    !Gettable<T> || std::tuple_size_v<std::remove_cvref_t<T>> == A;
+concept HasArity = !Gettable<T> || gettable_arity<T>::value == A;
 
 /** Satisfied if all arguments have the same arity, equal to `A`. */
 template <std::size_t A, typename... Args>
@@ -114,7 +230,13 @@ concept HaveArity = (... && HasArity<A, Args>);
 
 /* Satisfied if all arguments have the same arity. */
 template <typename... Args>
-concept SameArity = HaveArity<first_arity_or_zero<Args...>(), Args...>;
+concept SameArity = HaveArity<first_arity_v<Args...>, Args...>;
+
+/** True if `forward_copy_rvalue<A, I>()` copies its argument of type `T`. */
+template <std::size_t A, std::size_t I, typename T>
+inline constexpr bool copies_rvalue = A != I + 1 && !Gettable<T> &&
+                                      !Protected<T> &&
+                                      std::is_rvalue_reference_v<T&&>;
 
 /**
  * Tries to forward the given value `t`.
@@ -123,16 +245,56 @@ concept SameArity = HaveArity<first_arity_or_zero<Args...>(), Args...>;
  * during the last invoke, i.e. when `A == I + 1`.
  */
 template <std::size_t A, std::size_t I, typename T>
-constexpr decltype(auto) forward_copy_rvalue(T&& t)
+constexpr decltype(auto) forward_copy_rvalue(T&& t) noexcept(
+    !copies_rvalue<A, I, T> ||
+    std::is_nothrow_constructible_v<std::remove_cvref_t<T>,
+                                    std::remove_reference_t<T>&>)
 {
-    if constexpr (A != I + 1 && !Gettable<T> && !Protected<T> &&
-                  std::is_rvalue_reference_v<T&&>) {
+    if constexpr (copies_rvalue<A, I, T>) {
         return std::remove_cvref_t<T>(t);
     } else {
         return std::forward<T>(t);
     }
 }
 
+/** True if `get_element<I>()` cannot throw for an argument of type `T`. */
+template <std::size_t I, typename T>
+consteval bool nothrow_get_element()
+{
+    if constexpr (HasStdGet<I, T>) {
+        return noexcept(std::get<I>(std::declval<T>()));
+    } else if constexpr (HasMemberGet<I, T>) {
+        return noexcept(std::declval<T>().template get<I>());
+    } else {
+        return noexcept(adl::adl_get<I>(std::declval<T>()));
+    }
+}
+
+/** The `I`-th element of the Gettable `t`, accessed as in `HasGet`. */
+template <std::size_t I, typename T>
+constexpr decltype(auto) get_element(T&& t) noexcept(
+    nothrow_get_element<I, T>())
+{
+    if constexpr (HasStdGet<I, T>) {
+        return std::get<I>(std::forward<T>(t));
+    } else if constexpr (HasMemberGet<I, T>) {
+        return std::forward<T>(t).template get<I>();
+    } else {
+        return adl::adl_get<I>(std::forward<T>(t));
+    }
+}
+
+/** True if `try_get<I>()` cannot throw for an argument of type `T`. */
+template <std::size_t I, typename T>
+consteval bool nothrow_try_get()
+{
+    if constexpr (Gettable<T>) {
+        return nothrow_get_element<I, T>();
+    } else {
+        return true;
+    }
+}
+
 /**
  * Returns the appropriate value based on `T`:
  * - if `T` is Gettable, returns the `I`-th element of `t`
@@ -140,10 +302,10 @@ constexpr decltype(auto) forward_copy_rvalue(T&& t)
  * - otherwise returns `t` as it is
  */
 template <std::size_t I, typename T> 
-constexpr decltype(auto) try_get(T&& t)
+constexpr decltype(auto) try_get(T&& t) noexcept(nothrow_try_get<I, T>())
 {
     if constexpr (Gettable<T>) {
-        return std::get<I>(std::forward<T>(t));
+        return get_element<I>(std::forward<T>(t));
     } else if constexpr (Protected<T>) {
         auto&& value = std::forward<T>(t).value;
         return std::forward<decltype(value)>(value);
@@ -161,7 +323,8 @@ constexpr decltype(auto) try_get(T&& t)
  * `std::monostate`, so that the result of `invoke_forall` isn't broken.
  */
 template <std::size_t I, typename... Args>
-constexpr decltype(auto) invoke_at(Args&&...args)
+constexpr decltype(auto) invoke_at(Args&&...args) noexcept(
+    noexcept(std::invoke(try_get<I>(std::forward<Args>(args))...)))
 {
     auto call_invoke = [&]() -> decltype(auto) {
         return std::invoke(try_get<I>(std::forward<Args>(args))...);
@@ -175,14 +338,119 @@ constexpr decltype(auto) invoke_at(Args&&...args)
     }
 }
 
+/** Hooks policy that does nothing, so that every hook call compiles away. */
+struct no_hooks {};
+
+/**
+ * Calls `hooks.enter<I, Ts...>()` on construction and `hooks.exit<I, Ts...>()`
+ * on destruction, where `Ts` are the types of the arguments passed to the
+ * `I`-th `std::invoke`. Hooks are skipped during constant evaluation.
+ */
+template <typename Hooks, std::size_t I, typename... Ts>
+struct hook_scope {
+    Hooks& hooks;
+
+    explicit constexpr hook_scope(Hooks& h) : hooks(h)
+    {
+        if !consteval {
+            hooks.template enter<I, Ts...>();
+        }
+    }
+
+    constexpr ~hook_scope()
+    {
+        if !consteval {
+            hooks.template exit<I, Ts...>();
+        }
+    }
+};
+
+/**
+ * True if `hooks.enter<I, Ts...>()` cannot throw. A throwing `exit()` ends
+ * the program anyway, since it is called from a destructor.
+ */
+template <typename Hooks, std::size_t I, typename... Ts>
+consteval bool nothrow_hooks()
+{
+    if constexpr (std::same_as<Hooks, no_hooks>) {
+        return true;
+    } else {
+        return noexcept(std::declval<Hooks&>().template enter<I, Ts...>());
+    }
+}
+
 /**
  * Serves as a `invoke_at()` wrapper that forwards its arguments
- * through `forward_copy_rvalue()`.
+ * through `forward_copy_rvalue()` and surrounds the call with `hooks`.
  */
+template <std::size_t A, std::size_t I, typename Hooks, typename... Args>
+constexpr decltype(auto) invoke_at_wrapper(Hooks& hooks,
+                                           Args&&...args) noexcept(
+    noexcept(invoke_at<I>(
+        forward_copy_rvalue<A, I>(std::forward<Args>(args))...)) &&
+    nothrow_hooks<Hooks, I,
+                  decltype(try_get<I>(forward_copy_rvalue<A, I>(
+                      std::forward<Args>(args))))...>())
+{
+    if constexpr (std::same_as<Hooks, no_hooks>) {
+        return invoke_at<I>(
+            forward_copy_rvalue<A, I>(std::forward<Args>(args))...);
+    } else {
+        hook_scope<Hooks, I,
+                   decltype(try_get<I>(forward_copy_rvalue<A, I>(
+                       std::forward<Args>(args))))...> scope(hooks);
+
+        return invoke_at<I>(
+            forward_copy_rvalue<A, I>(std::forward<Args>(args))...);
+    }
+}
+
+/** Return type of the `I`-th invoke out of `A`. */
 template <std::size_t A, std::size_t I, typename... Args>
-constexpr decltype(auto) invoke_at_wrapper(Args&&...args)
+using invoke_at_result_t = decltype(invoke_at_wrapper<A, I>(
+    std::declval<no_hooks&>(), std::declval<Args>()...));
+
+/**
+ * Type under which the result of the `I`-th invoke is stored in a tuple:
+ * lvalue references are kept, everything else is stored by value.
+ */
+template <std::size_t A, std::size_t I, typename... Args>
+using tuple_element_result_t = std::conditional_t<
+    std::is_lvalue_reference_v<invoke_at_result_t<A, I, Args...>>,
+    invoke_at_result_t<A, I, Args...>,
+    std::remove_cvref_t<invoke_at_result_t<A, I, Args...>>>;
+
+/**
+ * True if all invokes of `invoke_for_all_indices()` and the construction of
+ * its result from theirs cannot throw. Results stored in a `std::array`
+ * are constructed in place unless they are rvalue references, while
+ * `std::tuple` always moves them.
+ */
+template <typename Hooks, typename... Args, std::size_t... Is>
+consteval bool nothrow_for_all_indices(std::index_sequence<Is...>)
 {
-    return invoke_at<I>(forward_copy_rvalue<A, I>(std::forward<Args>(args))...);
+    constexpr size_t arity = sizeof...(Is);
+
+    using first_result_type = invoke_at_result_t<arity, 0, Args...>;
+
+    constexpr bool invokes = (... && noexcept(invoke_at_wrapper<arity, Is>(
+                                         std::declval<Hooks&>(),
+                                         std::declval<Args>()...)));
+
+    if constexpr ((... && std::same_as<first_result_type,
+                                       invoke_at_result_t<arity, Is,
+                                                          Args...>>)) {
+        return invokes &&
+               (!std::is_rvalue_reference_v<first_result_type> ||
+                std::is_nothrow_constructible_v<
+                    std::remove_reference_t<first_result_type>,
+                    first_result_type>);
+    } else {
+        return invokes &&
+               (... && std::is_nothrow_constructible_v<
+                           tuple_element_result_t<arity, Is, Args...>,
+                           invoke_at_result_t<arity, Is, Args...>>);
+    }
 }
 
 /**
@@ -192,67 +460,100 @@ constexpr decltype(auto) invoke_at_wrapper(Args&&...args)
  * If each call results in the same return type, returns a container that
  * satisfies the `std::ranges::random_access_range` concept.
  */
-template <std::size_t... Is, typename... Args>
-constexpr decltype(auto) invoke_for_all_indices(std::index_sequence<Is...>,
-                                                Args&&...args)
+template <typename Hooks, std::size_t... Is, typename... Args>
+constexpr decltype(auto) invoke_for_all_indices(Hooks& hooks,
+                                                std::index_sequence<Is...>,
+                                                Args&&...args) noexcept(
+    nothrow_for_all_indices<Hooks, Args...>(std::index_sequence<Is...>{}))
 {
     constexpr size_t arity = sizeof...(Is);
 
-    using first_result_type =
-        decltype(invoke_at_wrapper<arity, 0>(std::forward<Args>(args)...));
+    using first_result_type = invoke_at_result_t<arity, 0, Args...>;
 
     if constexpr ((... && std::same_as<first_result_type,
-                                       decltype(invoke_at_wrapper<arity, Is>(
-                                           std::forward<Args>(args)...))>)) {
+                                       invoke_at_result_t<arity, Is,
+                                                          Args...>>)) {
         using base_type = std::remove_reference_t<first_result_type>;
 
         if constexpr (std::is_lvalue_reference_v<first_result_type>) {
             return std::array<std::reference_wrapper<base_type>, arity>
             {
-                invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)... 
+                invoke_at_wrapper<arity, Is>(hooks,
+                                             std::forward<Args>(args)...)...
             };
         } else {
             return std::array<base_type, arity>
             {
-                invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)...
+                invoke_at_wrapper<arity, Is>(hooks,
+                                             std::forward<Args>(args)...)...
             };
         }
     } else {
-        return std::tuple<std::conditional_t<std::is_lvalue_reference_v<
-            decltype(invoke_at_wrapper<arity, Is>
-                    (std::forward<Args>(args)...))>,
-            decltype(invoke_at_wrapper<arity, Is>
-                    (std::forward<Args>(args)...)),
-            std::remove_cvref_t<
-            decltype(invoke_at_wrapper<arity, Is>
-                    (std::forward<Args>(args)...))>>...>
+        return std::tuple<tuple_element_result_t<arity, Is, Args...>...>
         {
-            invoke_at_wrapper<arity, Is>(std::forward<Args>(args)...)...
+            invoke_at_wrapper<arity, Is>(hooks, std::forward<Args>(args)...)...
         };
     }
 }
 
+/** True if `invoke_forall_hooked()` cannot throw for arguments `Args`. */
+template <typename Hooks, typename... Args>
+consteval bool nothrow_forall()
+{
+    if constexpr (NoneGettable<Args...>) {
+        return noexcept(invoke_at_wrapper<1, 0>(std::declval<Hooks&>(),
+                                                std::declval<Args>()...));
+    } else {
+        return noexcept(invoke_for_all_indices(
+            std::declval<Hooks&>(),
+            std::make_index_sequence<first_arity_or_zero<Args...>()>{},
+            std::declval<Args>()...));
+    }
+}
+
 /**
- * If none of the arguments `(arg1, ..., argn)` are Gettable,
- * returns a result equivalent to calling `std::invoke(arg1, ..., argn)`.
+ * Same as `invoke_forall()`, but calls `hooks` around each invoke.
  *
- * Otherwise, the return value `ret` is an object such that
- * `std::get<i>(ret)` is the result of the `i`-th invoke.
+ * `Hooks` provides member templates `enter<I, Ts...>()` and
+ * `exit<I, Ts...>()`, see `hook_scope`.
  */
-template <typename... Args>
+template <typename Hooks, typename... Args>
 requires NonEmpty<Args...> && SameArity<Args...>
-constexpr decltype(auto) invoke_forall(Args&&...args)
+constexpr decltype(auto) invoke_forall_hooked(Hooks& hooks,
+                                              Args&&...args) noexcept(
+    nothrow_forall<Hooks, Args...>())
 {
     if constexpr (NoneGettable<Args...>) {
-        return invoke_at<0>(std::forward<Args>(args)...);
+        return invoke_at_wrapper<1, 0>(hooks, std::forward<Args>(args)...);
     } else {
         constexpr size_t arity = first_arity_or_zero<Args...>();
 
-        return invoke_for_all_indices(std::make_index_sequence<arity>{},
+        return invoke_for_all_indices(hooks, std::make_index_sequence<arity>{},
                                       std::forward<Args>(args)...);
     }
 }
 
+/**
+ * If none of the arguments `(arg1, ..., argn)` are Gettable,
+ * returns a result equivalent to calling `std::invoke(arg1, ..., argn)`.
+ *
+ * Otherwise, the return value `ret` is an object such that
+ * `std::get<i>(ret)` is the result of the `i`-th invoke.
+ */
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr decltype(auto) invoke_forall(Args&&...args) noexcept(
+    nothrow_forall<no_hooks, Args...>())
+{
+    no_hooks hooks;
+    return invoke_forall_hooked(hooks, std::forward<Args>(args)...);
+}
+
+/** Number of invokes performed by `invoke_forall(args...)`. */
+template <typename... Args>
+inline constexpr std::size_t invoke_count =
+    NoneGettable<Args...> ? 1 : first_arity_v<Args...>;
+
 /**
  * Makes `invoke_forall` treat protected Gettable argument `arg` as a regular
  * argument.
@@ -271,13 +572,36 @@ constexpr decltype(auto) protect_arg(T&& arg)
 
 } /* namespace detail */
 
-template <typename... Args>
-constexpr decltype(auto) invoke_forall(Args&&...args)
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr decltype(auto) invoke_forall(Args&&...args) noexcept(
+    noexcept(detail::invoke_forall(std::forward<Args>(args)...)))
 {
     return detail::invoke_forall(std::forward<Args>(args)...);
 }
 
-template <typename T> 
+/** Type returned by `invoke_forall(std::declval<Args>()...)`. */
+INVOKE_FORALL_EXPORT template <typename... Args>
+using invoke_forall_result_t =
+    decltype(invoke_forall(std::declval<Args>()...));
+
+/**
+ * True if `invoke_forall(std::declval<Args>()...)` cannot throw: every
+ * callable is nothrow invocable on its arguments, and getting, copying and
+ * storing the arguments and results cannot throw either.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+inline constexpr bool is_nothrow_invoke_forall_v =
+    noexcept(invoke_forall(std::declval<Args>()...));
+
+/**
+ * True if `invoke_forall(std::declval<Args>()...)` returns a trivially
+ * copyable object (never a reference), which can be copied with `memcpy`.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+inline constexpr bool is_trivially_copyable_invoke_forall_v =
+    std::is_trivially_copyable_v<invoke_forall_result_t<Args...>>;
+
+INVOKE_FORALL_EXPORT template <typename T>
 constexpr decltype(auto) protect_arg(T&& arg)
 {
     return detail::protect_arg(std::forward<T>(arg));
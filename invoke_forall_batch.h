@@ -0,0 +1,456 @@
+/**
+ * Batched `invoke_forall` over many argument sets.
+ *
+ * `invoke_forall_batch(policy, options, args...)` performs
+ * `invoke_forall(args_r...)` for every row `r`, where `args_r` is the `r`-th
+ * element of every argument wrapped with `batch_arg()` and the argument
+ * itself otherwise. All results are written into a single `rows x arity`
+ * buffer, in row-major or column-major order, instead of one small array
+ * per row. Rows are split into chunks that are run according to `policy`,
+ * while the invokes of each row stay unrolled at compile time.
+ *
+ * Arguments are only ever passed as lvalues (or as the prvalues produced by
+ * the batched ranges), since they are used by many rows.
+ */
+
+#ifndef INVOKE_FORALL_BATCH_H
+#define INVOKE_FORALL_BATCH_H
+
+#include "invoke_forall.h"
+#include "invoke_forall_parallel.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class batch_layout {
+    /* Results of one row are contiguous. */
+    row_major,
+    /* Results of one index are contiguous. */
+    column_major,
+};
+
+struct batch_options {
+    batch_layout layout = batch_layout::row_major;
+    /* Rows per task, `0` picks a size from the number of threads. */
+    std::size_t grain = 0;
+};
+
+namespace detail
+{
+
+/** Selects the constructor of `batch_result` that constructs in place. */
+struct batch_fill_t {};
+
+inline constexpr batch_fill_t batch_fill{};
+
+} /* namespace detail */
+
+/**
+ * A `rows x cols` buffer of results of `invoke_forall_batch()`. Held in
+ * plain storage rather than a `std::vector`, so that `bool` results are
+ * real `bool` objects that `data()` and `operator()` can refer to, and
+ * results are constructed in place, so they need no default constructor.
+ * Move-only.
+ */
+template <typename T>
+class batch_result {
+public:
+    /** A buffer of value-initialized elements. */
+    batch_result(std::size_t rows, std::size_t cols, batch_layout layout)
+    requires std::default_initializable<T>
+        : batch_result(detail::batch_fill, rows, cols, layout,
+                       [](T *first, std::size_t n) {
+                           std::uninitialized_value_construct_n(first, n);
+                       })
+    {
+    }
+
+    /**
+     * A buffer whose elements are constructed by `fill(data, rows * cols)`,
+     * which either constructs all of them or none and throws.
+     */
+    template <typename Fill>
+    batch_result(detail::batch_fill_t, std::size_t rows, std::size_t cols,
+                 batch_layout layout, Fill&& fill)
+        : values(std::allocator<T>{}.allocate(rows * cols)), row_count(rows),
+          col_count(cols), order(layout)
+    {
+        try {
+            std::forward<Fill>(fill)(values, rows * cols);
+        } catch (...) {
+            std::allocator<T>{}.deallocate(values, rows * cols);
+            throw;
+        }
+    }
+
+    batch_result(batch_result&& other) noexcept
+        : values(std::exchange(other.values, nullptr)),
+          row_count(std::exchange(other.row_count, 0)),
+          col_count(std::exchange(other.col_count, 0)), order(other.order)
+    {
+    }
+
+    batch_result& operator=(batch_result&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            values = std::exchange(other.values, nullptr);
+            row_count = std::exchange(other.row_count, 0);
+            col_count = std::exchange(other.col_count, 0);
+            order = other.order;
+        }
+        return *this;
+    }
+
+    ~batch_result() { release(); }
+
+    T& operator()(std::size_t row, std::size_t col)
+    {
+        return values[offset(row, col)];
+    }
+
+    const T& operator()(std::size_t row, std::size_t col) const
+    {
+        return values[offset(row, col)];
+    }
+
+    std::size_t rows() const { return row_count; }
+    std::size_t cols() const { return col_count; }
+    batch_layout layout() const { return order; }
+
+    std::span<T> data() { return { values, row_count * col_count }; }
+
+    std::span<const T> data() const
+    {
+        return { values, row_count * col_count };
+    }
+
+    /** Results of row `r`, contiguous in the row-major layout only. */
+    std::span<const T> row(std::size_t r) const
+    {
+        if (order != batch_layout::row_major) {
+            throw std::logic_error("batch_result::row needs row-major layout");
+        }
+        return data().subspan(r * col_count, col_count);
+    }
+
+    /** Results of index `c`, contiguous in the column-major layout only. */
+    std::span<const T> column(std::size_t c) const
+    {
+        if (order != batch_layout::column_major) {
+            throw std::logic_error(
+                "batch_result::column needs column-major layout");
+        }
+        return data().subspan(c * row_count, row_count);
+    }
+
+private:
+    std::size_t offset(std::size_t row, std::size_t col) const
+    {
+        return order == batch_layout::row_major ? row * col_count + col
+                                                : col * row_count + row;
+    }
+
+    void release() noexcept
+    {
+        if (values) {
+            std::destroy_n(values, row_count * col_count);
+            std::allocator<T>{}.deallocate(values, row_count * col_count);
+            values = nullptr;
+        }
+    }
+
+    T *values;
+    std::size_t row_count;
+    std::size_t col_count;
+    batch_layout order;
+};
+
+namespace detail
+{
+
+/** A random access range whose `r`-th element is used in row `r`. */
+template <typename R>
+struct batched_arg {
+    R range;
+    using is_batched_tag = void;
+};
+
+/** Satisfied if `T` is wrapped by `batch_arg()`. */
+template <typename T>
+concept Batched = requires { typename std::remove_cvref_t<T>::is_batched_tag; };
+
+/** The argument `arg` as used in row `r`. */
+template <typename T>
+constexpr decltype(auto) row_arg(T& arg, std::size_t r)
+{
+    if constexpr (Batched<T>) {
+        return std::ranges::begin(arg.range)[r];
+    } else {
+        return (arg);
+    }
+}
+
+template <typename T>
+using row_arg_t = decltype(row_arg(std::declval<T&>(), 0));
+
+/** Number of invokes per row for the arguments `Args`. */
+template <typename... Args>
+inline constexpr std::size_t batch_arity = invoke_count<row_arg_t<Args>...>;
+
+template <typename Is, typename... Args>
+struct batch_value;
+
+template <std::size_t... Is, typename... Args>
+struct batch_value<std::index_sequence<Is...>, Args...> {
+    static constexpr std::size_t arity = sizeof...(Is);
+
+    using first = invoke_at_result_t<arity, 0, row_arg_t<Args>...>;
+
+    static_assert((... && std::same_as<first,
+                                       invoke_at_result_t<arity, Is,
+                                                          row_arg_t<Args>...>>),
+                  "all invokes of a batch have to return the same type");
+
+    using type = stored_result_t<first>;
+};
+
+/** Type of the elements of the result buffer. */
+template <typename... Args>
+using batch_value_t =
+    typename batch_value<std::make_index_sequence<batch_arity<Args...>>,
+                         Args...>::type;
+
+/** Number of rows, i.e. the common size of all batched arguments. */
+template <typename... Args>
+std::size_t batch_rows(Args&...args)
+{
+    std::size_t rows = 0;
+    bool first = true;
+
+    auto check = [&](auto& arg) {
+        if constexpr (Batched<decltype(arg)>) {
+            auto size = static_cast<std::size_t>(std::ranges::size(arg.range));
+            if (!first && size != rows) {
+                throw std::length_error(
+                    "batched arguments have different sizes");
+            }
+            rows = size;
+            first = false;
+        }
+    };
+    (check(args), ...);
+
+    return rows;
+}
+
+/** Element `col` of row `row` in the `rows x arity` buffer `out`. */
+template <batch_layout Layout, std::size_t Arity, typename T>
+T *batch_slot(T *out, std::size_t row, std::size_t col, std::size_t rows)
+{
+    if constexpr (Layout == batch_layout::row_major) {
+        return out + row * Arity + col;
+    } else {
+        return out + col * rows + row;
+    }
+}
+
+/** Destroys the results of the rows `[begin, end)`. */
+template <batch_layout Layout, std::size_t Arity, typename T>
+void destroy_rows(T *out, std::size_t begin, std::size_t end, std::size_t rows)
+{
+    for (std::size_t row = begin; row < end; ++row) {
+        for (std::size_t col = 0; col < Arity; ++col) {
+            std::destroy_at(batch_slot<Layout, Arity>(out, row, col, rows));
+        }
+    }
+}
+
+/**
+ * Performs all invokes of row `row` and stores them in `out`, constructing
+ * them in uninitialized storage if `Construct` and assigning them
+ * otherwise. A constructed row is destroyed again if an invoke throws.
+ */
+template <batch_layout Layout, bool Construct, typename T, std::size_t... Is,
+          typename... Args>
+void invoke_row(std::index_sequence<Is...>, T *out, std::size_t row,
+                std::size_t rows, Args&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    auto slot = [&](std::size_t col) {
+        return batch_slot<Layout, arity>(out, row, col, rows);
+    };
+
+    if constexpr (Construct) {
+        std::size_t built = 0;
+        try {
+            ((std::construct_at(slot(Is), invoke_at_wrapper<arity, Is>(
+                                              hooks, row_arg(args, row)...)),
+              ++built),
+             ...);
+        } catch (...) {
+            for (std::size_t col = 0; col < built; ++col) {
+                std::destroy_at(slot(col));
+            }
+            throw;
+        }
+    } else {
+        ((*slot(Is) =
+              invoke_at_wrapper<arity, Is>(hooks, row_arg(args, row)...)),
+         ...);
+    }
+}
+
+template <batch_layout Layout, bool Construct, typename T, typename... Args>
+void invoke_rows(T *out, std::size_t begin, std::size_t end, std::size_t rows,
+                 Args&...args)
+{
+    constexpr std::size_t arity = batch_arity<Args...>;
+
+    for (std::size_t row = begin; row < end; ++row) {
+        try {
+            invoke_row<Layout, Construct>(std::make_index_sequence<arity>{},
+                                          out, row, rows, args...);
+        } catch (...) {
+            if constexpr (Construct) {
+                destroy_rows<Layout, arity>(out, begin, row, rows);
+            }
+            throw;
+        }
+    }
+}
+
+/** Number of rows per task. */
+template <typename Policy>
+std::size_t batch_grain(const Policy& policy, std::size_t rows,
+                        std::size_t grain)
+{
+    if (grain != 0) {
+        return grain;
+    }
+
+    std::size_t threads = policy_threads(policy);
+    return std::max<std::size_t>(rows / (4 * threads), 1);
+}
+
+/**
+ * Runs all rows according to `policy` and stores their results in the
+ * `rows x arity` buffer `out`. If `Construct`, `out` is uninitialized, and
+ * if an invoke throws, no result is left constructed.
+ */
+template <bool Construct, typename Policy, typename T, typename... Args>
+void invoke_batch(const Policy& policy, T *out, std::size_t rows,
+                  batch_options options, Args&...args)
+{
+    constexpr std::size_t arity = batch_arity<Args...>;
+
+    std::size_t grain = batch_grain(policy, rows, options.grain);
+    /* chunks whose rows were all constructed, one byte per chunk */
+    std::vector<unsigned char> built(Construct ? (rows + grain - 1) / grain
+                                               : 0);
+
+    auto run = [&]<batch_layout Layout>() {
+        try {
+            for_each_chunk(policy, rows, grain,
+                           [&](std::size_t begin, std::size_t end) {
+                invoke_rows<Layout, Construct>(out, begin, end, rows,
+                                               args...);
+                if constexpr (Construct) {
+                    built[begin / grain] = 1;
+                }
+            });
+        } catch (...) {
+            if constexpr (Construct) {
+                for (std::size_t c = 0; c < built.size(); ++c) {
+                    if (built[c]) {
+                        destroy_rows<Layout, arity>(
+                            out, c * grain, std::min(rows, (c + 1) * grain),
+                            rows);
+                    }
+                }
+            }
+            throw;
+        }
+    };
+
+    if (options.layout == batch_layout::row_major) {
+        run.template operator()<batch_layout::row_major>();
+    } else {
+        run.template operator()<batch_layout::column_major>();
+    }
+}
+
+} /* namespace detail */
+
+/** Marks `range` as the argument that supplies one element per row. */
+template <typename R>
+requires std::ranges::random_access_range<R> && std::ranges::sized_range<R>
+constexpr auto batch_arg(R&& range)
+{
+    return detail::batched_arg<R>{ std::forward<R>(range) };
+}
+
+/**
+ * Writes the results of all rows into `out`, which has to have exactly
+ * `rows * arity` elements, laid out as given by `options`.
+ */
+template <typename Policy, typename T, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<detail::row_arg_t<Args>...> &&
+         (... || detail::Batched<Args>)
+void invoke_forall_batch_into(const Policy& policy, std::span<T> out,
+                              batch_options options, Args&&...args)
+{
+    constexpr std::size_t arity = detail::batch_arity<Args...>;
+
+    std::size_t rows = detail::batch_rows(args...);
+    if (out.size() != rows * arity) {
+        throw std::length_error("batch result buffer has a wrong size");
+    }
+
+    detail::invoke_batch<false>(policy, out.data(), rows, options, args...);
+}
+
+/**
+ * Same as above, but allocates and returns the result buffer, with every
+ * result constructed in place. Lvalue reference results are stored as
+ * `std::reference_wrapper`s.
+ */
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<detail::row_arg_t<Args>...> &&
+         (... || detail::Batched<Args>)
+auto invoke_forall_batch(const Policy& policy, batch_options options,
+                         Args&&...args)
+{
+    using value_type = detail::batch_value_t<Args...>;
+
+    std::size_t rows = detail::batch_rows(args...);
+
+    return batch_result<value_type>(
+        detail::batch_fill, rows, detail::batch_arity<Args...>,
+        options.layout, [&](value_type *out, std::size_t) {
+            detail::invoke_batch<true>(policy, out, rows, options, args...);
+        });
+}
+
+/** Same as above, run with the `parallel` policy in row-major layout. */
+template <typename F, typename... Args>
+requires (!detail::ExecutionPolicy<F>)
+auto invoke_forall_batch(F&& f, Args&&...args)
+{
+    return invoke_forall_batch(parallel, batch_options{}, std::forward<F>(f),
+                               std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_BATCH_H */
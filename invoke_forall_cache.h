@@ -0,0 +1,430 @@
+/**
+ * Persistent on-disk cache of `invoke_forall` results (POSIX only).
+ *
+ * `invoke_forall_cached(file, key, args...)` returns the same result as
+ * `invoke_forall(args...)`. The first time the result is written to `file`
+ * in a versioned binary format, keyed by a hash of `key` and of the argument
+ * values. Later calls, including calls in later runs of the program, map
+ * the file into memory and hand the result out without running any of the
+ * callables. Entries that are stale (different key, arguments, result type
+ * or format version) or corrupt (bad size, magic or checksum) are
+ * recomputed and rewritten.
+ *
+ * Callables are not hashed: function pointers, member pointers and
+ * stateless callables are identified only by `key`, which the caller
+ * chooses per function, e.g. its name and a version. Stateful callables
+ * are rejected, pass their state as arguments instead.
+ *
+ * Arguments are hashed by value with a fixed FNV-1a over a canonical byte
+ * sequence, never over padding: integers, enums, `float` and `double`,
+ * `std::string`, `std::string_view` and C strings, and built-in arrays and
+ * Gettables of these. Other pointers are rejected, as the hash would not
+ * cover what they point to. The result has to consist of arithmetic values
+ * and enums, possibly in `std::array`s or other trivially copyable
+ * Gettables, so that it holds no pointers or references.
+ */
+
+#ifndef INVOKE_FORALL_CACHE_H
+#define INVOKE_FORALL_CACHE_H
+
+#include "invoke_forall.h"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace detail
+{
+
+/** Version of the file format, bump on every incompatible change. */
+inline constexpr std::uint32_t cache_format_version = 2;
+
+inline constexpr char cache_magic[8] = { 'I', 'F', 'C', 'A',
+                                         'C', 'H', 'E', '\0' };
+
+/** Header of a cache file. The payload starts right after it. */
+struct alignas(64) cache_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t payload_align;
+    std::uint64_t payload_size;
+    std::uint64_t key_hash;
+    std::uint64_t type_hash;
+    std::uint64_t checksum;
+};
+
+/** 64-bit FNV-1a. */
+constexpr std::uint64_t fnv1a(const unsigned char *data, std::size_t size,
+                              std::uint64_t seed = 0xcbf29ce484222325ULL)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        seed ^= data[i];
+        seed *= 0x100000001b3ULL;
+    }
+    return seed;
+}
+
+constexpr std::uint64_t fnv1a(std::string_view s,
+                              std::uint64_t seed = 0xcbf29ce484222325ULL)
+{
+    for (char c : s) {
+        seed ^= static_cast<unsigned char>(c);
+        seed *= 0x100000001b3ULL;
+    }
+    return seed;
+}
+
+/** Mixes the 8 bytes of `v` into `seed`, least significant first. */
+constexpr std::uint64_t fnv1a(std::uint64_t v, std::uint64_t seed)
+{
+    for (int i = 0; i < 8; ++i) {
+        seed ^= (v >> (8 * i)) & 0xff;
+        seed *= 0x100000001b3ULL;
+    }
+    return seed;
+}
+
+/**
+ * Mixes the kind and size of the next value into `seed`, so that values of
+ * different kinds with the same bytes, e.g. `1` and `1u`, differ.
+ */
+constexpr std::uint64_t fnv1a_tag(char kind, std::uint64_t size,
+                                  std::uint64_t seed)
+{
+    return fnv1a(size, fnv1a(std::string_view(&kind, 1), seed));
+}
+
+/**
+ * Hash of the compiler's spelling of `T`. Only used for the result type,
+ * which `cacheable_result` limits to named standard and enum types.
+ */
+template <typename T>
+constexpr std::uint64_t type_hash(std::uint64_t seed)
+{
+    return fnv1a(__PRETTY_FUNCTION__, seed);
+}
+
+/** Strings hashed by their characters. */
+template <typename T>
+concept CacheString = std::same_as<T, std::string> ||
+                      std::same_as<T, std::string_view> ||
+                      std::same_as<T, const char *> || std::same_as<T, char *>;
+
+/**
+ * Arguments with no value of their own: function and member pointers and
+ * stateless callables. They are identified by the key passed to
+ * `invoke_forall_cached()` instead, since addresses change between runs
+ * and types of different lambdas may be spelled alike.
+ */
+template <typename T>
+concept CacheCallable =
+    std::is_member_pointer_v<T> || std::is_function_v<T> ||
+    (std::is_pointer_v<T> && std::is_function_v<std::remove_pointer_t<T>>) ||
+    (std::is_class_v<T> && std::is_empty_v<T>);
+
+template <typename T>
+struct is_reference_wrapper : std::false_type {};
+
+template <typename T>
+struct is_reference_wrapper<std::reference_wrapper<T>> : std::true_type {};
+
+/**
+ * Mixes the value of `t` into `seed` with FNV-1a, one value at a time and
+ * never through padding: integers as 8 little-endian bytes, floating-point
+ * numbers by their bits, strings by their characters, arrays and Gettables
+ * element by element, references by what they refer to.
+ */
+template <typename T>
+constexpr std::uint64_t hash_value(const T& t, std::uint64_t seed)
+{
+    using U = std::remove_cvref_t<T>;
+
+    if constexpr (Protected<U>) {
+        return hash_value(t.value, seed);
+    } else if constexpr (is_reference_wrapper<U>::value) {
+        return hash_value(t.get(), seed);
+    } else if constexpr (std::is_enum_v<U>) {
+        return hash_value(std::to_underlying(t), fnv1a_tag('e', 0, seed));
+    } else if constexpr (std::is_integral_v<U>) {
+        seed = fnv1a_tag(std::is_signed_v<U> ? 'i' : 'u', sizeof(U), seed);
+        return fnv1a(static_cast<std::uint64_t>(t), seed);
+    } else if constexpr (std::is_floating_point_v<U>) {
+        static_assert(sizeof(U) == 4 || sizeof(U) == 8,
+                      "invoke_forall_cached can not hash long double, "
+                      "whose object representation has padding");
+        using bits_type = std::conditional_t<sizeof(U) == 4, std::uint32_t,
+                                             std::uint64_t>;
+        return fnv1a(std::bit_cast<bits_type>(t),
+                     fnv1a_tag('f', sizeof(U), seed));
+    } else if constexpr (CacheString<U>) {
+        std::string_view s(t);
+        return fnv1a(s, fnv1a_tag('s', s.size(), seed));
+    } else if constexpr (CacheCallable<U>) {
+        return seed;
+    } else if constexpr (std::is_pointer_v<U>) {
+        static_assert(!std::is_pointer_v<U>,
+                      "invoke_forall_cached can not hash pointer arguments "
+                      "other than C strings, pass what they point to");
+        return seed;
+    } else if constexpr (std::is_array_v<U>) {
+        seed = fnv1a_tag('a', std::extent_v<U>, seed);
+        for (const auto& element : t) {
+            seed = hash_value(element, seed);
+        }
+        return seed;
+    } else if constexpr (Gettable<const U&>) {
+        seed = fnv1a_tag('g', std::tuple_size_v<U>, seed);
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((seed = hash_value(get_element<Is>(t), seed)), ...);
+            return seed;
+        }(std::make_index_sequence<std::tuple_size_v<U>>{});
+    } else {
+        static_assert(Gettable<const U&>,
+                      "invoke_forall_cached arguments have to be arithmetic, "
+                      "enums, strings, stateless callables, or arrays and "
+                      "Gettables of them");
+        return seed;
+    }
+}
+
+/**
+ * True for results that can be read back from a cache file in another run:
+ * arithmetic values, enums and `std::monostate`, and trivially copyable
+ * Gettables of them, which rules out pointers and references.
+ */
+template <typename T>
+struct cacheable_result
+    : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                         std::same_as<T, std::monostate>> {};
+
+template <Gettable T>
+struct cacheable_result<T> {
+    static constexpr bool value =
+        std::is_trivially_copyable_v<T> &&
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return (... && (!std::is_reference_v<std::tuple_element_t<Is, T>> &&
+                            cacheable_result<std::remove_cv_t<
+                                std::tuple_element_t<Is, T>>>::value));
+        }(std::make_index_sequence<std::tuple_size_v<T>>{});
+};
+
+/** Read-only mapping of a whole file, unmapped on destruction. */
+class file_mapping {
+public:
+    file_mapping() = default;
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    file_mapping(file_mapping&& other) noexcept
+        : data(std::exchange(other.data, nullptr)),
+          size(std::exchange(other.size, 0))
+    {
+    }
+
+    file_mapping& operator=(file_mapping&& other) noexcept
+    {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        return *this;
+    }
+
+    ~file_mapping()
+    {
+        if (data != nullptr) {
+            munmap(data, size);
+        }
+    }
+
+    /** Maps `file`, returns an empty mapping on any error. */
+    static file_mapping open(const std::filesystem::path& file)
+    {
+        file_mapping mapping;
+
+        int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return mapping;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *data = mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                              PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                mapping.data = data;
+                mapping.size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+
+        close(fd);
+        return mapping;
+    }
+
+    const unsigned char *bytes() const
+    {
+        return static_cast<const unsigned char *>(data);
+    }
+
+    std::size_t length() const { return size; }
+
+private:
+    void *data = nullptr;
+    std::size_t size = 0;
+};
+
+/** Returns a header describing a payload of type `T` with the given key. */
+template <typename T>
+cache_header make_cache_header(std::uint64_t key_hash, const T& payload)
+{
+    cache_header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_format_version;
+    header.payload_align = alignof(T);
+    header.payload_size = sizeof(T);
+    header.key_hash = key_hash;
+    header.type_hash = type_hash<T>(fnv1a(""));
+    header.checksum = fnv1a(reinterpret_cast<const unsigned char *>(&payload),
+                            sizeof(T));
+    return header;
+}
+
+/** Checks that `mapping` holds a valid entry for `T` under `key_hash`. */
+template <typename T>
+bool valid_cache_entry(const file_mapping& mapping, std::uint64_t key_hash)
+{
+    if (mapping.length() != sizeof(cache_header) + sizeof(T)) {
+        return false;
+    }
+
+    cache_header header;
+    std::memcpy(&header, mapping.bytes(), sizeof(header));
+
+    return std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0 &&
+           header.version == cache_format_version &&
+           header.payload_align == alignof(T) &&
+           header.payload_size == sizeof(T) && header.key_hash == key_hash &&
+           header.type_hash == type_hash<T>(fnv1a("")) &&
+           header.checksum ==
+               fnv1a(mapping.bytes() + sizeof(cache_header), sizeof(T));
+}
+
+/**
+ * Writes the entry to a temporary file and renames it over `file`, so that
+ * readers never observe a partially written entry. Errors are ignored, the
+ * entry is simply recomputed next time.
+ */
+template <typename T>
+void write_cache_entry(const std::filesystem::path& file,
+                       std::uint64_t key_hash, const T& payload)
+{
+    cache_header header = make_cache_header(key_hash, payload);
+
+    std::filesystem::path tmp = file;
+    tmp += ".tmp." + std::to_string(getpid());
+
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+        return;
+    }
+
+    bool ok = ::write(fd, &header, sizeof(header)) ==
+                  static_cast<ssize_t>(sizeof(header)) &&
+              ::write(fd, &payload, sizeof(T)) ==
+                  static_cast<ssize_t>(sizeof(T));
+    ok = close(fd) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp, file, ec);
+    }
+    if (!ok || ec) {
+        std::filesystem::remove(tmp, ec);
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * Result of `invoke_forall_cached()`: either a view into the mapped cache
+ * file or the freshly computed value.
+ */
+template <typename T>
+class cached_result {
+public:
+    explicit cached_result(detail::file_mapping mapping)
+        : mapping(std::move(mapping))
+    {
+    }
+
+    explicit cached_result(T value) : computed(std::move(value)) {}
+
+    const T& get() const
+    {
+        if (computed) {
+            return *computed;
+        }
+        return *std::launder(reinterpret_cast<const T *>(
+            mapping.bytes() + sizeof(detail::cache_header)));
+    }
+
+    const T& operator*() const { return get(); }
+    const T *operator->() const { return &get(); }
+
+    /** True if the result was read from the cache file. */
+    bool from_cache() const { return !computed; }
+
+private:
+    detail::file_mapping mapping;
+    std::optional<T> computed;
+};
+
+/**
+ * Same as `invoke_forall(args...)`, but persists the result in `file`,
+ * see the top of this file. `key` names the callables and should change
+ * whenever what they compute does.
+ */
+template <typename... Args>
+auto invoke_forall_cached(const std::filesystem::path& file,
+                          std::string_view key, Args&&...args)
+{
+    using result_type = std::remove_cvref_t<decltype(invoke_forall(
+        std::forward<Args>(args)...))>;
+
+    static_assert(detail::cacheable_result<result_type>::value,
+                  "invoke_forall_cached requires a result made of "
+                  "arithmetic values and enums, without pointers or "
+                  "references");
+
+    std::uint64_t key_hash = detail::fnv1a("invoke_forall_cached");
+    key_hash = detail::hash_value(key, key_hash);
+    ((key_hash = detail::hash_value(args, key_hash)), ...);
+
+    auto mapping = detail::file_mapping::open(file);
+    if (detail::valid_cache_entry<result_type>(mapping, key_hash)) {
+        return cached_result<result_type>(std::move(mapping));
+    }
+
+    result_type result = invoke_forall(std::forward<Args>(args)...);
+    detail::write_cache_entry(file, key_hash, result);
+
+    return cached_result<result_type>(std::move(result));
+}
+
+#endif /* INVOKE_FORALL_CACHE_H */
@@ -0,0 +1,100 @@
+/**
+ * Results of `invoke_forall` converted to one type.
+ *
+ * `invoke_forall_common` converts all results to one type and always returns
+ * a `std::array`.
+ */
+
+#ifndef INVOKE_FORALL_COMMON_H
+#define INVOKE_FORALL_COMMON_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace detail
+{
+
+template <typename... Ts>
+concept HaveCommonType = requires { typename std::common_type<Ts...>::type; };
+
+/**
+ * Element type of `invoke_forall_common<T>(args...)`: `T`, or the common
+ * type of the results of all invokes if `T` is `void`.
+ */
+template <typename T, typename Is, typename... Args>
+struct common_result;
+
+template <typename T, std::size_t... Is, typename... Args>
+struct common_result<T, std::index_sequence<Is...>, Args...> {
+    using type = T;
+};
+
+template <std::size_t... Is, typename... Args>
+struct common_result<void, std::index_sequence<Is...>, Args...> {
+    template <std::size_t I>
+    using result_type = std::remove_cvref_t<
+        invoke_at_result_t<sizeof...(Is), I, Args...>>;
+
+    static_assert(HaveCommonType<result_type<Is>...>,
+                  "the results of invoke_forall_common have no common type");
+
+    using type = std::common_type_t<result_type<Is>...>;
+};
+
+template <typename T, typename... Args>
+using common_result_t =
+    typename common_result<T, std::make_index_sequence<invoke_count<Args...>>,
+                           Args...>::type;
+
+/**
+ * Same as `invoke_for_all_indices()`, but constructs every element of the
+ * returned array directly from the result of its invoke. Only implicit
+ * conversions are allowed, so a result is never turned into a `T` through
+ * an explicit constructor, such as an `int` into an `std::vector` of that
+ * size.
+ */
+template <typename T, std::size_t... Is, typename... Args>
+constexpr std::array<T, sizeof...(Is)>
+invoke_for_all_indices_as(std::index_sequence<Is...>, Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    static_assert((... && std::is_convertible_v<
+                              invoke_at_result_t<arity, Is, Args...>, T>),
+                  "the results of invoke_forall_common have to be implicitly "
+                  "convertible to the element type");
+
+    return std::array<T, arity>
+    {
+        T(invoke_at_wrapper<arity, Is>(hooks, std::forward<Args>(args)...))...
+    };
+}
+
+template <typename T, typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_common(Args&&...args)
+{
+    return invoke_for_all_indices_as<common_result_t<T, Args...>>(
+        std::make_index_sequence<invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)`, but returns a `std::array` of the
+ * results implicitly converted to `T`, or to their `std::common_type_t` if
+ * `T` is not given, even if the invokes return different types.
+ */
+INVOKE_FORALL_EXPORT template <typename T = void, typename... Args>
+constexpr auto invoke_forall_common(Args&&...args)
+{
+    return detail::invoke_forall_common<T>(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_COMMON_H */
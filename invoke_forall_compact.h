@@ -0,0 +1,244 @@
+/**
+ * Padding-free results of `invoke_forall`.
+ *
+ * `invoke_forall_compact` returns the results in a `compact_tuple`, which
+ * lays them out in the order of decreasing alignment to avoid padding.
+ */
+
+#ifndef INVOKE_FORALL_COMPACT_H
+#define INVOKE_FORALL_COMPACT_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace detail
+{
+
+/** Alignment of a member of type `T`, which may be a reference. */
+template <typename T>
+inline constexpr std::size_t member_align =
+    std::is_reference_v<T> ? alignof(void *) : alignof(T);
+
+/** Indices of `Ts` sorted by decreasing alignment, ties in index order. */
+template <typename... Ts>
+inline constexpr auto compact_order = [] {
+    std::array<std::size_t, sizeof...(Ts)> order{};
+    std::array<std::size_t, sizeof...(Ts)> align{ member_align<Ts>... };
+
+    /* insertion sort, which is stable and usable in constant expressions */
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        std::size_t j = i;
+        for (; j > 0 && align[order[j - 1]] < align[i]; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    return order;
+}();
+
+/**
+ * Stores the elements `Ks...` of `Types` (an `std::tuple`) as nested
+ * members in the given order. Each level is aligned at least as strictly
+ * as the next one, so the nesting adds no padding over a flat struct.
+ */
+template <typename Types, std::size_t... Ks>
+struct compact_storage {
+    constexpr compact_storage() = default;
+
+    template <typename Refs>
+    constexpr compact_storage(std::in_place_t, Refs&&)
+    {
+    }
+
+    constexpr bool operator==(const compact_storage&) const = default;
+};
+
+template <typename Types, std::size_t K, std::size_t... Ks>
+struct compact_storage<Types, K, Ks...> {
+    using head_type = std::tuple_element_t<K, Types>;
+
+    constexpr compact_storage() : head(), tail() {}
+
+    /** Takes the elements from `refs`, a tuple of references to all. */
+    template <typename Refs>
+    constexpr compact_storage(std::in_place_t, Refs&& refs)
+        : head(std::get<K>(std::move(refs))),
+          tail(std::in_place, std::move(refs))
+    {
+    }
+
+    template <std::size_t I>
+    constexpr auto& get() noexcept
+    {
+        if constexpr (I == K) {
+            return head;
+        } else {
+            return tail.template get<I>();
+        }
+    }
+
+    template <std::size_t I>
+    constexpr const auto& get() const noexcept
+    {
+        if constexpr (I == K) {
+            return head;
+        } else {
+            return tail.template get<I>();
+        }
+    }
+
+    constexpr bool operator==(const compact_storage&) const = default;
+
+    [[no_unique_address]] head_type head;
+    [[no_unique_address]] compact_storage<Types, Ks...> tail;
+};
+
+template <typename Types, typename Is>
+struct compact_storage_for;
+
+template <typename... Ts, std::size_t... Is>
+struct compact_storage_for<std::tuple<Ts...>, std::index_sequence<Is...>> {
+    using type =
+        compact_storage<std::tuple<Ts...>, compact_order<Ts...>[Is]...>;
+};
+
+} /* namespace detail */
+
+/**
+ * A tuple of `Ts...` laid out in the order of decreasing alignment, see the
+ * top of this file.
+ */
+INVOKE_FORALL_EXPORT template <typename... Ts>
+class compact_tuple {
+    using storage_type = typename detail::compact_storage_for<
+        std::tuple<Ts...>, std::index_sequence_for<Ts...>>::type;
+
+public:
+    /** Bytes saved over `std::tuple<Ts...>`. */
+    static constexpr std::size_t bytes_saved =
+        sizeof(std::tuple<Ts...>) - sizeof(storage_type);
+
+    constexpr compact_tuple() : storage() {}
+
+    /** Takes the elements in the order of `Ts`. */
+    template <typename... Us>
+    requires(sizeof...(Us) == sizeof...(Ts) && sizeof...(Ts) > 0 &&
+             (... && std::is_constructible_v<Ts, Us>))
+    constexpr explicit(!(... && std::is_convertible_v<Us, Ts>))
+        compact_tuple(Us&&...values)
+        : storage(std::in_place,
+                  std::forward_as_tuple(std::forward<Us>(values)...))
+    {
+    }
+
+    /** The `I`-th element, in the order of `Ts`. */
+    template <std::size_t I>
+    constexpr std::tuple_element_t<I, std::tuple<Ts...>>& get() & noexcept
+    {
+        return storage.template get<I>();
+    }
+
+    template <std::size_t I>
+    constexpr const std::tuple_element_t<I, std::tuple<Ts...>>&
+    get() const& noexcept
+    {
+        return storage.template get<I>();
+    }
+
+    template <std::size_t I>
+    constexpr std::tuple_element_t<I, std::tuple<Ts...>>&& get() && noexcept
+    {
+        using type = std::tuple_element_t<I, std::tuple<Ts...>>;
+        return static_cast<type&&>(storage.template get<I>());
+    }
+
+    template <std::size_t I>
+    constexpr const std::tuple_element_t<I, std::tuple<Ts...>>&&
+    get() const&& noexcept
+    {
+        using type = const std::tuple_element_t<I, std::tuple<Ts...>>;
+        return static_cast<type&&>(storage.template get<I>());
+    }
+
+    /* `get<I>(t)`, found by argument-dependent lookup. */
+    template <std::size_t I>
+    friend constexpr decltype(auto) get(compact_tuple& t) noexcept
+    {
+        return t.template get<I>();
+    }
+
+    template <std::size_t I>
+    friend constexpr decltype(auto) get(const compact_tuple& t) noexcept
+    {
+        return t.template get<I>();
+    }
+
+    template <std::size_t I>
+    friend constexpr decltype(auto) get(compact_tuple&& t) noexcept
+    {
+        return std::move(t).template get<I>();
+    }
+
+    template <std::size_t I>
+    friend constexpr decltype(auto) get(const compact_tuple&& t) noexcept
+    {
+        return std::move(t).template get<I>();
+    }
+
+    constexpr bool operator==(const compact_tuple&) const = default;
+
+private:
+    storage_type storage;
+};
+
+template <typename... Ts>
+struct std::tuple_size<compact_tuple<Ts...>>
+    : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <std::size_t I, typename... Ts>
+struct std::tuple_element<I, compact_tuple<Ts...>>
+    : std::tuple_element<I, std::tuple<Ts...>> {};
+
+namespace detail
+{
+
+template <std::size_t... Is, typename... Args>
+constexpr auto invoke_for_all_indices_compact(std::index_sequence<Is...>,
+                                              Args&&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    return compact_tuple<tuple_element_result_t<arity, Is, Args...>...>{
+        invoke_at_wrapper<arity, Is>(hooks, std::forward<Args>(args)...)...
+    };
+}
+
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_compact(Args&&...args)
+{
+    return invoke_for_all_indices_compact(
+        std::make_index_sequence<invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)`, but always returns the results in a
+ * `compact_tuple`, which needs less padding than `std::tuple` when they
+ * differ in alignment.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_compact(Args&&...args)
+{
+    return detail::invoke_forall_compact(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_COMPACT_H */
@@ -0,0 +1,201 @@
+/**
+ * Deadline-bounded `invoke_forall` with cooperative cancellation.
+ *
+ * `invoke_forall_with_deadline(deadline, args...)` performs the invokes of
+ * `invoke_forall(args...)` until `deadline` passes and returns the results
+ * of the invokes that completed, each as a `std::optional`, together with
+ * their number. The clock and a `std::stop_token` are checked before every
+ * invoke; invokes whose callable accepts a trailing `std::stop_token` get
+ * one that is stopped at the deadline, so they can give up early too.
+ *
+ * With an execution policy, the invokes of tasks that have not started by
+ * the deadline are skipped. Invokes that are already running are always
+ * waited for, since they may use the arguments.
+ */
+
+#ifndef INVOKE_FORALL_DEADLINE_H
+#define INVOKE_FORALL_DEADLINE_H
+
+#include "invoke_forall.h"
+#include "invoke_forall_parallel.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Result of `invoke_forall_with_deadline()`: `values` holds the `i`-th
+ * result as its `i`-th element (a `std::optional`, empty if the invoke did
+ * not complete before the deadline), `completed` the number of non-empty
+ * elements.
+ */
+template <typename Values>
+struct deadline_result {
+    Values values;
+    std::size_t completed;
+};
+
+namespace detail
+{
+
+/**
+ * Satisfied if the `I`-th out of `A` invokes on arguments of types `Args`
+ * can take a `std::stop_token` as its last argument.
+ */
+template <std::size_t A, std::size_t I, typename... Args>
+concept AcceptsStopToken = std::is_invocable_v<
+    decltype(try_get<I>(forward_copy_rvalue<A, I>(std::declval<Args>())))...,
+    std::stop_token>;
+
+/**
+ * Same as `invoke_stored()`, but passes `token` as the last argument if the
+ * callable accepts it.
+ */
+template <std::size_t A, std::size_t I, typename... Args>
+decltype(auto) invoke_stored_until(std::tuple<Args...>& args,
+                                   std::stop_token token)
+{
+    return [&]<std::size_t... Js>(std::index_sequence<Js...>)
+               -> decltype(auto) {
+        no_hooks hooks;
+        if constexpr (AcceptsStopToken<A, I, concurrent_arg_t<Args>...>) {
+            return invoke_at_wrapper<A, I>(
+                hooks, forward_concurrent<Args>(std::get<Js>(args))...,
+                std::move(token));
+        } else {
+            return invoke_at_wrapper<A, I>(
+                hooks, forward_concurrent<Args>(std::get<Js>(args))...);
+        }
+    }(std::index_sequence_for<Args...>{});
+}
+
+template <std::size_t A, std::size_t I, typename... Args>
+using deadline_value_t = stored_result_t<decltype(invoke_stored_until<A, I>(
+    std::declval<std::tuple<Args...>&>(), std::declval<std::stop_token>()))>;
+
+template <typename Is, typename... Args>
+struct deadline_values;
+
+template <std::size_t... Is, typename... Args>
+struct deadline_values<std::index_sequence<Is...>, Args...> {
+    static constexpr std::size_t arity = sizeof...(Is);
+
+    /* True if some callable takes the stop token. */
+    static constexpr bool uses_token =
+        (... || AcceptsStopToken<arity, Is, concurrent_arg_t<Args>...>);
+
+    using type = std::conditional_t<
+        same_results<deadline_value_t<arity, Is, Args...>...>,
+        std::array<std::optional<deadline_value_t<arity, 0, Args...>>, arity>,
+        std::tuple<std::optional<deadline_value_t<arity, Is, Args...>>...>>;
+};
+
+/**
+ * Requests a stop of `source` at `deadline`, unless destroyed before. Only
+ * needed when some callable takes the stop token, since the invokes check
+ * the clock themselves otherwise.
+ */
+template <typename Clock, typename Duration>
+class deadline_timer {
+public:
+    deadline_timer(std::stop_source source,
+                   std::chrono::time_point<Clock, Duration> deadline)
+        : thread([source, deadline](std::stop_token cancelled) mutable {
+              std::mutex mutex;
+              std::condition_variable_any cv;
+              std::unique_lock lock(mutex);
+
+              cv.wait_until(lock, cancelled, deadline, [] { return false; });
+              if (!cancelled.stop_requested()) {
+                  source.request_stop();
+              }
+          })
+    {
+    }
+
+private:
+    std::jthread thread;
+};
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(policy, args...)`, but stops starting invokes once
+ * `deadline` has passed, see the top of this file. Rethrows the exception
+ * of the failed invoke with the lowest index.
+ */
+template <typename Policy, typename Clock, typename Duration, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...>
+auto invoke_forall_with_deadline(
+    Policy&& policy, std::chrono::time_point<Clock, Duration> deadline,
+    Args&&...args)
+{
+    constexpr std::size_t arity = detail::invoke_count<Args...>;
+
+    using values_info =
+        detail::deadline_values<std::make_index_sequence<arity>, Args&&...>;
+    using values_type = typename values_info::type;
+    using args_type = std::tuple<Args&&...>;
+
+    struct state {
+        explicit state(args_type refs) : args(std::move(refs)) {}
+
+        args_type args;
+        values_type values{};
+        std::atomic<std::size_t> completed = 0;
+        std::stop_source source;
+    };
+
+    static constexpr auto invoke_at =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<void (*)(state&), arity>{ [](state& st) {
+                std::get<Is>(st.values).emplace(
+                    detail::invoke_stored_until<arity, Is>(
+                        st.args, st.source.get_token()));
+                st.completed.fetch_add(1, std::memory_order_relaxed);
+            }... };
+        }(std::make_index_sequence<arity>{});
+
+    state st(args_type(std::forward<Args>(args)...));
+
+    std::optional<detail::deadline_timer<Clock, Duration>> timer;
+    if constexpr (values_info::uses_token) {
+        timer.emplace(st.source, deadline);
+    }
+
+    detail::for_each_chunk(policy, arity, detail::policy_grain(policy, arity),
+                           [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (st.source.stop_requested() || Clock::now() >= deadline) {
+                st.source.request_stop();
+                return;
+            }
+            invoke_at[i](st);
+        }
+    });
+
+    return deadline_result<values_type>{ std::move(st.values),
+                                         st.completed.load() };
+}
+
+/** Same as above, with the invokes run in order on the calling thread. */
+template <typename Clock, typename Duration, typename... Args>
+requires detail::NonEmpty<Args...> && detail::SameArity<Args...>
+auto invoke_forall_with_deadline(
+    std::chrono::time_point<Clock, Duration> deadline, Args&&...args)
+{
+    return invoke_forall_with_deadline(sequenced, deadline,
+                                       std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_DEADLINE_H */
@@ -1,10 +1,16 @@
+#ifndef INVOKE_FORALL_MODULE
 #include "invoke_forall.h"
+#endif
 #include <array>
 #include <functional>
 #include <iostream>
 #include <string>
 #include <tuple>
 
+#ifdef INVOKE_FORALL_MODULE
+import invoke_forall;
+#endif
+
 namespace {
     int sum1(const std::array<int, 3> &t) {
         int res = 0;
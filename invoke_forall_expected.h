@@ -0,0 +1,214 @@
+/**
+ * Per-invoke error collection for `invoke_forall`.
+ *
+ * `invoke_forall_expected` performs the same invokes, but catches the
+ * exceptions of every invoke separately and returns `std::expected` results.
+ * With `fail_fast` the invokes after the first failing one are skipped.
+ */
+
+#ifndef INVOKE_FORALL_EXPECTED_H
+#define INVOKE_FORALL_EXPECTED_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <expected>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+/**
+ * Makes `invoke_forall_expected` skip all invokes after the first one that
+ * failed, instead of performing every invoke.
+ */
+INVOKE_FORALL_EXPORT struct fail_fast_t {
+    bool enabled = true;
+};
+
+INVOKE_FORALL_EXPORT inline constexpr fail_fast_t fail_fast{};
+
+/** Error of the invokes skipped in the fail-fast mode. */
+INVOKE_FORALL_EXPORT struct invoke_skipped : std::exception {
+    const char *what() const noexcept override
+    {
+        return "invoke skipped after an earlier invoke failed";
+    }
+};
+
+namespace detail
+{
+
+/** Satisfied if `T` is a specialization of `std::expected`. */
+template <typename T>
+concept Expected = requires {
+    typename std::remove_cvref_t<T>::value_type;
+    typename std::remove_cvref_t<T>::error_type;
+    requires std::same_as<
+        std::remove_cvref_t<T>,
+        std::expected<typename std::remove_cvref_t<T>::value_type,
+                      typename std::remove_cvref_t<T>::error_type>>;
+};
+
+/**
+ * Error type of an `invoke_forall_expected` result for an invoke that
+ * returns `std::expected<T, E>`: `E` itself if it can hold an exception,
+ * otherwise a `std::variant` with the returned errors as alternative `0`
+ * and the thrown exceptions as alternative `1`.
+ */
+template <typename E>
+using expected_error_t =
+    std::conditional_t<std::is_constructible_v<E, std::exception_ptr>, E,
+                       std::variant<E, std::exception_ptr>>;
+
+/** Type of an `invoke_forall_expected` result for an invoke returning `R`. */
+template <typename R>
+struct expected_result_for {
+    using type = std::expected<
+        std::conditional_t<std::is_lvalue_reference_v<R>,
+                           std::reference_wrapper<std::remove_reference_t<R>>,
+                           std::remove_cvref_t<R>>,
+        std::exception_ptr>;
+};
+
+template <Expected R>
+struct expected_result_for<R> {
+    using type = std::expected<
+        typename std::remove_cvref_t<R>::value_type,
+        expected_error_t<typename std::remove_cvref_t<R>::error_type>>;
+};
+
+/**
+ * Type of the `I`-th element of an `invoke_forall_expected` result:
+ * - results that already are `std::expected<T, E>` keep `T` and `E`, with
+ *   `E` widened by `expected_error_t` when it can not hold an exception,
+ * - lvalue references are stored as `std::reference_wrapper`,
+ * - other results are stored by value,
+ * with `std::exception_ptr` as the error type in the last two cases.
+ */
+template <typename R>
+using expected_result_for_t = typename expected_result_for<R>::type;
+
+template <std::size_t A, std::size_t I, typename... Args>
+using expected_result_t =
+    expected_result_for_t<invoke_at_result_t<A, I, Args...>>;
+
+/**
+ * Performs the `I`-th invoke like `invoke_at_wrapper()`, but returns its
+ * result or the exception it threw as a `std::expected`.
+ *
+ * Sets `failed` if the invoke threw or returned an error. If `fail_fast` is
+ * set and an earlier invoke failed, skips the invoke and returns an
+ * `invoke_skipped` error instead.
+ */
+template <std::size_t A, std::size_t I, typename... Args>
+constexpr expected_result_t<A, I, Args...>
+invoke_at_expected(bool fail_fast, bool& failed, Args&&...args)
+{
+    using result_type = expected_result_t<A, I, Args...>;
+    using error_type = typename result_type::error_type;
+
+    if (fail_fast && failed) {
+        return std::unexpected<error_type>(
+            std::make_exception_ptr(invoke_skipped{}));
+    }
+
+    try {
+        no_hooks hooks;
+        result_type result(
+            invoke_at_wrapper<A, I>(hooks, std::forward<Args>(args)...));
+
+        failed = failed || !result.has_value();
+        return result;
+    } catch (...) {
+        failed = true;
+        return std::unexpected<error_type>(std::current_exception());
+    }
+}
+
+/**
+ * Same as `invoke_for_all_indices()`, but every invoke is done through
+ * `invoke_at_expected()`, so one failing invoke does not prevent the others.
+ */
+template <std::size_t... Is, typename... Args>
+constexpr auto invoke_for_all_indices_expected(fail_fast_t policy,
+                                               std::index_sequence<Is...>,
+                                               Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+
+    using first_result_type = expected_result_t<arity, 0, Args...>;
+
+    bool failed = false;
+
+    if constexpr ((... && std::same_as<first_result_type,
+                                       expected_result_t<arity, Is,
+                                                         Args...>>)) {
+        return std::array<first_result_type, arity>
+        {
+            invoke_at_expected<arity, Is>(policy.enabled, failed,
+                                          std::forward<Args>(args)...)...
+        };
+    } else {
+        return std::tuple<expected_result_t<arity, Is, Args...>...>
+        {
+            invoke_at_expected<arity, Is>(policy.enabled, failed,
+                                          std::forward<Args>(args)...)...
+        };
+    }
+}
+
+/**
+ * Same as `invoke_forall()`, but the `i`-th result is a `std::expected`
+ * holding either the result of the `i`-th invoke or the exception it threw.
+ */
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_expected(fail_fast_t policy, Args&&...args)
+{
+    if constexpr (NoneGettable<Args...>) {
+        bool failed = false;
+        return invoke_at_expected<1, 0>(policy.enabled, failed,
+                                        std::forward<Args>(args)...);
+    } else {
+        constexpr size_t arity = first_arity_or_zero<Args...>();
+
+        return invoke_for_all_indices_expected(
+            policy, std::make_index_sequence<arity>{},
+            std::forward<Args>(args)...);
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)`, but never throws from an invoke: the
+ * `i`-th result is a `std::expected` with either the result of the `i`-th
+ * invoke or the exception it threw. Invokes that return `std::expected`
+ * themselves keep their result type if its error type can hold a
+ * `std::exception_ptr`; otherwise their error type `E` becomes
+ * `std::variant<E, std::exception_ptr>`, with returned errors kept as `E`.
+ * All invokes are performed even if some of them fail.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_expected(Args&&...args)
+{
+    return detail::invoke_forall_expected(fail_fast_t{ false },
+                                          std::forward<Args>(args)...);
+}
+
+/**
+ * Same as above, but if `policy` is enabled, the invokes after the first
+ * failing one are skipped and their results hold an `invoke_skipped` error.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_expected(fail_fast_t policy, Args&&...args)
+{
+    return detail::invoke_forall_expected(policy, std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_EXPECTED_H */
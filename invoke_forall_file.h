@@ -0,0 +1,478 @@
+/**
+ * Streaming `invoke_forall` over files of fixed-size records (POSIX only).
+ *
+ * `invoke_forall_file<Record, N>(input, sink, args...)` reads the file
+ * `input` as a sequence of trivially copyable `Record`s in chunks of `N`,
+ * and for every chunk `c` emits the results of `invoke_forall(args..., c)`
+ * to `sink` as a `std::span<const R>`. The last chunk may hold fewer than
+ * `N` records; only its invokes with indices below the number of records
+ * are performed.
+ *
+ * Reading, computing and writing form a pipeline: one thread reads the
+ * next chunk while the calling thread performs the invokes on the current
+ * one and another thread passes the previous results to `sink`. Each stage
+ * hands its chunks over in two alternating buffers, so memory use is
+ * bounded by two chunks of records and two chunks of results no matter
+ * how large the file is. The input is either mapped into memory, with
+ * pages dropped as soon as they have been copied, or read sequentially,
+ * which also works for pipes.
+ *
+ * Results are stored by value and have to be of a single type that is
+ * default constructible; `sink` is called in order from a single thread,
+ * and must not keep the span after it returns. Exceptions thrown by an
+ * invoke, by `sink` or by the I/O stop the pipeline and are rethrown by
+ * `invoke_forall_file` once all threads have finished.
+ */
+
+#ifndef INVOKE_FORALL_FILE_H
+#define INVOKE_FORALL_FILE_H
+
+#include "invoke_forall.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** How `invoke_forall_file` reads its input. */
+enum class file_input {
+    /* Map regular files into memory, read anything else. */
+    mapped,
+    /* Read the file sequentially. */
+    read,
+};
+
+struct file_stream_options {
+    file_input input = file_input::mapped;
+};
+
+struct file_stream_stats {
+    /* Records read from the input, one invoke each. */
+    std::size_t records = 0;
+    /* Chunks passed to the sink. */
+    std::size_t chunks = 0;
+};
+
+namespace detail
+{
+
+/** Owns a file descriptor, closed on destruction. */
+class file_descriptor {
+public:
+    explicit file_descriptor(int fd) : fd(fd) {}
+
+    file_descriptor(const file_descriptor&) = delete;
+    file_descriptor& operator=(const file_descriptor&) = delete;
+
+    file_descriptor(file_descriptor&& other) noexcept
+        : fd(std::exchange(other.fd, -1))
+    {
+    }
+
+    file_descriptor& operator=(file_descriptor&& other) noexcept
+    {
+        std::swap(fd, other.fd);
+        return *this;
+    }
+
+    ~file_descriptor()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    int get() const { return fd; }
+
+private:
+    int fd;
+};
+
+/** Reads whole records of `size` bytes from a mapped or read file. */
+class record_source {
+public:
+    record_source(const std::filesystem::path& file, std::size_t size,
+                  file_input input)
+        : fd(::open(file.c_str(), O_RDONLY | O_CLOEXEC)), record_size(size)
+    {
+        if (fd.get() < 0) {
+            throw std::system_error(errno, std::system_category(), "open");
+        }
+
+        struct stat st;
+        if (input == file_input::mapped && fstat(fd.get(), &st) == 0 &&
+            S_ISREG(st.st_mode)) {
+            length = static_cast<std::size_t>(st.st_size);
+            check_whole_records(length);
+            if (length > 0) {
+                map();
+            }
+        }
+    }
+
+    record_source(const record_source&) = delete;
+    record_source& operator=(const record_source&) = delete;
+
+    ~record_source()
+    {
+        if (data != nullptr) {
+            munmap(data, length);
+        }
+    }
+
+    /**
+     * Copies up to `n` records to `out`, returns the number copied, `0` at
+     * the end of the file.
+     */
+    std::size_t read(void *out, std::size_t n)
+    {
+        return data != nullptr ? copy_mapped(out, n) : read_fd(out, n);
+    }
+
+private:
+    void check_whole_records(std::size_t bytes) const
+    {
+        if (bytes % record_size != 0) {
+            throw std::runtime_error(
+                "invoke_forall_file input is not a whole number of records");
+        }
+    }
+
+    void map()
+    {
+        void *mapped =
+            mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (mapped == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category(), "mmap");
+        }
+        data = mapped;
+        madvise(data, length, MADV_SEQUENTIAL);
+    }
+
+    std::size_t copy_mapped(void *out, std::size_t n)
+    {
+        std::size_t bytes = std::min(n * record_size, length - offset);
+        std::memcpy(out, static_cast<const unsigned char *>(data) + offset,
+                    bytes);
+        offset += bytes;
+
+        /* Drop the pages copied so far, they are not read again. */
+        static const std::size_t page =
+            static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t done = offset / page * page;
+        if (done > dropped) {
+            madvise(static_cast<unsigned char *>(data) + dropped,
+                    done - dropped, MADV_DONTNEED);
+            dropped = done;
+        }
+
+        return bytes / record_size;
+    }
+
+    std::size_t read_fd(void *out, std::size_t n)
+    {
+        auto *bytes = static_cast<unsigned char *>(out);
+        std::size_t wanted = n * record_size;
+        std::size_t got = 0;
+
+        while (got < wanted) {
+            ssize_t r = ::read(fd.get(), bytes + got, wanted - got);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(),
+                                        "read");
+            }
+            if (r == 0) {
+                break;
+            }
+            got += static_cast<std::size_t>(r);
+        }
+
+        check_whole_records(got);
+        return got / record_size;
+    }
+
+    file_descriptor fd;
+    std::size_t record_size;
+    void *data = nullptr;
+    std::size_t length = 0;
+    std::size_t offset = 0;
+    std::size_t dropped = 0;
+};
+
+/**
+ * Two buffers passed from a producer to a consumer in order. Buffer `k`
+ * can be filled once buffer `k - 2` was released, and read once it was
+ * published. `finish()` ends the sequence, `cancel()` wakes and stops
+ * both sides.
+ */
+template <typename T>
+class double_buffer {
+public:
+    T& slot(std::uint64_t k) { return buffers[k % 2]; }
+
+    /** Waits until buffer `k` can be filled, false if cancelled. */
+    bool wait_writable(std::uint64_t k)
+    {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] { return cancelled || k - consumed < 2; });
+        return !cancelled;
+    }
+
+    /** Waits until buffer `k` was published, false if there is none. */
+    bool wait_readable(std::uint64_t k)
+    {
+        std::unique_lock lock(mutex);
+        changed.wait(lock,
+                     [&] { return cancelled || finished || produced > k; });
+        return !cancelled && produced > k;
+    }
+
+    void publish() { update([&] { ++produced; }); }
+
+    void release() { update([&] { ++consumed; }); }
+
+    void finish() { update([&] { finished = true; }); }
+
+    void cancel() { update([&] { cancelled = true; }); }
+
+private:
+    template <typename F>
+    void update(F f)
+    {
+        {
+            std::lock_guard lock(mutex);
+            f();
+        }
+        changed.notify_all();
+    }
+
+    std::array<T, 2> buffers{};
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::uint64_t produced = 0;
+    std::uint64_t consumed = 0;
+    bool finished = false;
+    bool cancelled = false;
+};
+
+template <typename T, std::size_t N>
+struct file_chunk {
+    std::array<T, N> values;
+    std::size_t count;
+};
+
+template <typename Record, std::size_t N, typename... Args>
+using file_result_t = std::remove_cvref_t<
+    invoke_at_result_t<N, 0, Args&..., std::array<Record, N>&>>;
+
+/**
+ * Performs the first `count` invokes of `invoke_forall(args..., chunk)`,
+ * storing their results in `out`.
+ */
+template <typename Record, typename R, std::size_t N, std::size_t... Is,
+          typename... Args>
+void invoke_file_chunk(std::array<R, N>& out, std::array<Record, N>& chunk,
+                       std::size_t count, std::index_sequence<Is...>,
+                       Args&...args)
+{
+    static_assert((... && std::same_as<R, std::remove_cvref_t<
+                                              invoke_at_result_t<
+                                                  N, Is, Args&...,
+                                                  std::array<Record, N>&>>>),
+                  "invoke_forall_file invokes have to return the same type");
+
+    no_hooks hooks;
+    (void)(... && (Is < count &&
+                   (out[Is] = invoke_at_wrapper<N, Is>(hooks, args..., chunk),
+                    true)));
+}
+
+/** State shared by the three stages of the pipeline. */
+template <typename Record, typename R, std::size_t N>
+struct file_pipeline {
+    double_buffer<file_chunk<Record, N>> input;
+    double_buffer<file_chunk<R, N>> output;
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    /** Stores the current exception unless one is stored, stops all stages. */
+    void fail() noexcept
+    {
+        {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        input.cancel();
+        output.cancel();
+    }
+};
+
+} /* namespace detail */
+
+/**
+ * Writes the results passed to it to a file as raw bytes, truncating the
+ * file first. Results have to be trivially copyable.
+ */
+class file_sink {
+public:
+    explicit file_sink(const std::filesystem::path& file)
+        : fd(::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644))
+    {
+        if (fd.get() < 0) {
+            throw std::system_error(errno, std::system_category(), "open");
+        }
+    }
+
+    template <typename T>
+    void operator()(std::span<const T> results)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "file_sink results have to be trivially copyable");
+
+        auto *bytes = reinterpret_cast<const unsigned char *>(results.data());
+        std::size_t left = results.size_bytes();
+
+        while (left > 0) {
+            ssize_t w = ::write(fd.get(), bytes, left);
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(),
+                                        "write");
+            }
+            bytes += w;
+            left -= static_cast<std::size_t>(w);
+        }
+    }
+
+private:
+    detail::file_descriptor fd;
+};
+
+/**
+ * Streams the records of `input` through `invoke_forall(args..., chunk)`
+ * in chunks of `N`, see the top of this file.
+ */
+template <typename Record, std::size_t N, typename Sink, typename... Args>
+requires detail::NonEmpty<Args...> && (N > 0) &&
+         detail::SameArity<Args..., std::array<Record, N>>
+file_stream_stats invoke_forall_file(file_stream_options options,
+                                     const std::filesystem::path& input,
+                                     Sink&& sink, Args&&...args)
+{
+    static_assert(std::is_trivially_copyable_v<Record>,
+                  "invoke_forall_file records have to be trivially copyable");
+
+    using result_type = detail::file_result_t<Record, N, Args...>;
+    static_assert(std::is_default_constructible_v<result_type>,
+                  "invoke_forall_file results have to be default "
+                  "constructible");
+
+    detail::record_source source(input, sizeof(Record), options.input);
+
+    /* Chunks can be large, keep them off the stack. */
+    auto pipeline =
+        std::make_unique<detail::file_pipeline<Record, result_type, N>>();
+    file_stream_stats stats;
+
+    std::jthread reader([&] {
+        try {
+            for (std::uint64_t k = 0; pipeline->input.wait_writable(k); ++k) {
+                auto& chunk = pipeline->input.slot(k);
+                chunk.count = source.read(chunk.values.data(), N);
+                if (chunk.count > 0) {
+                    pipeline->input.publish();
+                }
+                if (chunk.count < N) {
+                    break;
+                }
+            }
+            pipeline->input.finish();
+        } catch (...) {
+            pipeline->fail();
+        }
+    });
+
+    std::jthread writer([&] {
+        try {
+            for (std::uint64_t k = 0; pipeline->output.wait_readable(k); ++k) {
+                auto& chunk = pipeline->output.slot(k);
+                sink(std::span<const result_type>(chunk.values.data(),
+                                                  chunk.count));
+                pipeline->output.release();
+            }
+        } catch (...) {
+            pipeline->fail();
+        }
+    });
+
+    try {
+        for (std::uint64_t k = 0; pipeline->input.wait_readable(k) &&
+                                  pipeline->output.wait_writable(k);
+             ++k) {
+            auto& in = pipeline->input.slot(k);
+            auto& out = pipeline->output.slot(k);
+
+            detail::invoke_file_chunk(out.values, in.values, in.count,
+                                      std::make_index_sequence<N>{},
+                                      args...);
+            out.count = in.count;
+            stats.records += in.count;
+            ++stats.chunks;
+
+            pipeline->input.release();
+            pipeline->output.publish();
+        }
+        pipeline->output.finish();
+    } catch (...) {
+        pipeline->fail();
+    }
+
+    reader.join();
+    writer.join();
+
+    if (pipeline->error) {
+        std::rethrow_exception(pipeline->error);
+    }
+    return stats;
+}
+
+/** Same as above, with the default options. */
+template <typename Record, std::size_t N, typename Sink, typename... Args>
+requires detail::NonEmpty<Args...> && (N > 0) &&
+         detail::SameArity<Args..., std::array<Record, N>>
+file_stream_stats invoke_forall_file(const std::filesystem::path& input,
+                                     Sink&& sink, Args&&...args)
+{
+    return invoke_forall_file<Record, N>(file_stream_options{}, input,
+                                         std::forward<Sink>(sink),
+                                         std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_FILE_H */
@@ -0,0 +1,273 @@
+/**
+ * Results of `invoke_forall` partitioned by type.
+ *
+ * `invoke_forall_grouped` partitions the results by type into one array per
+ * distinct type, together with the map back to the original indices.
+ */
+
+#ifndef INVOKE_FORALL_GROUPED_H
+#define INVOKE_FORALL_GROUPED_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace detail
+{
+
+/** A distinct address for every type, compared to tell types apart. */
+template <typename T>
+inline constexpr char type_tag = 0;
+
+/**
+ * Partition of `sizeof...(Ts)` results of types `Ts` into groups of equal
+ * types, numbered in the order of their first occurrence.
+ */
+template <typename... Ts>
+struct grouping {
+    static constexpr std::size_t size = sizeof...(Ts);
+
+    static constexpr std::array<const char *, size> tags{ &type_tag<Ts>... };
+
+    /*
+     * Group of every result and its position in the group, in one pass
+     * that compares every type with the first type of each group seen so
+     * far.
+     */
+    static constexpr auto layout = [] {
+        std::array<std::size_t, size> group_of{};
+        std::array<std::size_t, size> position_of{};
+        std::array<const char *, size> group_tags{};
+        std::array<std::size_t, size> group_sizes{};
+        std::size_t groups = 0;
+
+        for (std::size_t i = 0; i < size; ++i) {
+            std::size_t g = 0;
+            while (g < groups && group_tags[g] != tags[i]) {
+                ++g;
+            }
+            if (g == groups) {
+                group_tags[groups++] = tags[i];
+            }
+            group_of[i] = g;
+            position_of[i] = group_sizes[g]++;
+        }
+        return std::tuple{ group_of, position_of, groups };
+    }();
+
+    static constexpr std::array<std::size_t, size> group_of =
+        std::get<0>(layout);
+    static constexpr std::array<std::size_t, size> position_of =
+        std::get<1>(layout);
+    static constexpr std::size_t group_count = std::get<2>(layout);
+
+    /* Group of the results of type `T`, which has to be one of `Ts`. */
+    template <typename T>
+    static constexpr std::size_t group_of_type = [] {
+        std::size_t i = 0;
+        while (tags[i] != &type_tag<T>) {
+            ++i;
+        }
+        return group_of[i];
+    }();
+
+    template <std::size_t G>
+    static constexpr std::size_t group_size = [] {
+        std::size_t n = 0;
+        for (std::size_t g : group_of) {
+            n += g == G;
+        }
+        return n;
+    }();
+
+    /* original indices of the results in group `G`, in increasing order */
+    template <std::size_t G>
+    static constexpr auto indices = [] {
+        std::array<std::size_t, group_size<G>> result{};
+        for (std::size_t i = 0; i < size; ++i) {
+            if (group_of[i] == G) {
+                result[position_of[i]] = i;
+            }
+        }
+        return result;
+    }();
+
+    template <std::size_t G>
+    using group_type = std::tuple_element_t<indices<G>[0], std::tuple<Ts...>>;
+
+    template <std::size_t G>
+    using group_array = std::array<group_type<G>, group_size<G>>;
+
+    template <typename Gs>
+    struct groups_of;
+
+    template <std::size_t... Gs>
+    struct groups_of<std::index_sequence<Gs...>> {
+        using type = std::tuple<group_array<Gs>...>;
+    };
+
+    using groups_type =
+        typename groups_of<std::make_index_sequence<group_count>>::type;
+};
+
+} /* namespace detail */
+
+/**
+ * Results of `invoke_forall_grouped()`: the `i`-th result has type `Ts[i]`
+ * and is stored at `std::get<group_of[i]>(groups)[position_of[i]]`. Every
+ * group is a `std::array` of all results of one type, in index order, and
+ * `indices<G>` maps its elements back to their original indices.
+ */
+INVOKE_FORALL_EXPORT template <typename... Ts>
+struct grouped_result {
+private:
+    using info = detail::grouping<Ts...>;
+
+public:
+    using groups_type = typename info::groups_type;
+
+    /** Number of distinct result types. */
+    static constexpr std::size_t group_count = info::group_count;
+
+    static constexpr std::array<std::size_t, sizeof...(Ts)> group_of =
+        info::group_of;
+    static constexpr std::array<std::size_t, sizeof...(Ts)> position_of =
+        info::position_of;
+
+    template <std::size_t G>
+    static constexpr auto indices = info::template indices<G>;
+
+    /** Type of the results in group `G`. */
+    template <std::size_t G>
+    using group_type = typename info::template group_type<G>;
+
+    /** Group holding the results of type `T`. */
+    template <typename T>
+    requires(... || std::is_same_v<T, Ts>)
+    static constexpr std::size_t group_index =
+        info::template group_of_type<T>;
+
+    groups_type groups;
+
+    template <std::size_t G>
+    constexpr auto& group() noexcept
+    {
+        return std::get<G>(groups);
+    }
+
+    template <std::size_t G>
+    constexpr const auto& group() const noexcept
+    {
+        return std::get<G>(groups);
+    }
+
+    /** The results of type `T`. */
+    template <typename T>
+    constexpr auto& group() noexcept
+    {
+        return std::get<group_index<T>>(groups);
+    }
+
+    template <typename T>
+    constexpr const auto& group() const noexcept
+    {
+        return std::get<group_index<T>>(groups);
+    }
+
+    /** The `I`-th result. */
+    template <std::size_t I>
+    constexpr auto& at() noexcept
+    {
+        return std::get<group_of[I]>(groups)[position_of[I]];
+    }
+
+    template <std::size_t I>
+    constexpr const auto& at() const noexcept
+    {
+        return std::get<group_of[I]>(groups)[position_of[I]];
+    }
+};
+
+namespace detail
+{
+
+/** Type under which `invoke_forall_grouped()` groups the `I`-th result. */
+template <std::size_t A, std::size_t I, typename... Args>
+using grouped_value_t = std::conditional_t<
+    std::is_lvalue_reference_v<invoke_at_result_t<A, I, Args...>>,
+    std::reference_wrapper<
+        std::remove_reference_t<invoke_at_result_t<A, I, Args...>>>,
+    std::remove_cvref_t<invoke_at_result_t<A, I, Args...>>>;
+
+/** Moves the results of group `G` of `Result` out of the tuple `results`. */
+template <typename Result, std::size_t G, typename Results>
+constexpr auto make_group(Results& results)
+{
+    constexpr auto& indices = Result::template indices<G>;
+
+    return [&]<std::size_t... Ps>(std::index_sequence<Ps...>) {
+        return std::array<typename Result::template group_type<G>,
+                          sizeof...(Ps)>{
+            std::move(std::get<indices[Ps]>(results))...
+        };
+    }(std::make_index_sequence<indices.size()>{});
+}
+
+/**
+ * Performs the invokes in index order. Results of a single type are
+ * written straight into their group; otherwise every result is moved from
+ * a tuple into the array of its group.
+ */
+template <std::size_t... Is, typename... Args>
+constexpr auto invoke_for_all_indices_grouped(std::index_sequence<Is...>,
+                                              Args&&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    using result_type = grouped_result<grouped_value_t<arity, Is, Args...>...>;
+    using groups_type = typename result_type::groups_type;
+
+    if constexpr (result_type::group_count == 1) {
+        return result_type{ groups_type{
+            std::tuple_element_t<0, groups_type>{ invoke_at_wrapper<arity, Is>(
+                hooks, std::forward<Args>(args)...)... } } };
+    } else {
+        std::tuple<grouped_value_t<arity, Is, Args...>...> results{
+            invoke_at_wrapper<arity, Is>(hooks, std::forward<Args>(args)...)...
+        };
+
+        return [&]<std::size_t... Gs>(std::index_sequence<Gs...>) {
+            return result_type{ groups_type{
+                make_group<result_type, Gs>(results)... } };
+        }(std::make_index_sequence<result_type::group_count>{});
+    }
+}
+
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_grouped(Args&&...args)
+{
+    return invoke_for_all_indices_grouped(
+        std::make_index_sequence<invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)`, but returns the results partitioned by
+ * type into one `std::array` per distinct type, see `grouped_result`.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_grouped(Args&&...args)
+{
+    return detail::invoke_forall_grouped(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_GROUPED_H */
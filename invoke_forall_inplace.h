@@ -0,0 +1,170 @@
+/**
+ * In-place results of `invoke_forall`.
+ *
+ * `invoke_forall_inplace` writes every result back into the matching
+ * element of a Gettable argument as soon as its invoke returns.
+ */
+
+#ifndef INVOKE_FORALL_INPLACE_H
+#define INVOKE_FORALL_INPLACE_H
+
+#include "invoke_forall.h"
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Thrown by `invoke_forall_inplace` when an argument passes its target
+ * whole to every invoke, before any invoke is performed.
+ */
+INVOKE_FORALL_EXPORT struct inplace_target_aliased : std::exception {
+    const char *what() const noexcept override
+    {
+        return "an argument of invoke_forall_inplace is its whole target";
+    }
+};
+
+namespace detail
+{
+
+/**
+ * The type an argument passed unchanged to every invoke refers to, seen
+ * through `protect_arg()`, `std::reference_wrapper` and pointers.
+ */
+template <typename T>
+struct whole_arg {
+    using type = std::remove_cvref_t<T>;
+
+    static constexpr const void *address(const type& arg) noexcept
+    {
+        return &arg;
+    }
+};
+
+template <typename T>
+struct whole_arg<protected_arg<T>> : whole_arg<std::remove_cvref_t<T>> {
+    static constexpr const void *address(const protected_arg<T>& arg) noexcept
+    {
+        return whole_arg<std::remove_cvref_t<T>>::address(arg.value);
+    }
+};
+
+template <typename T>
+struct whole_arg<std::reference_wrapper<T>>
+    : whole_arg<std::remove_cv_t<T>> {
+    static constexpr const void *
+    address(const std::reference_wrapper<T>& arg) noexcept
+    {
+        return whole_arg<std::remove_cv_t<T>>::address(arg.get());
+    }
+};
+
+template <typename T>
+struct whole_arg<T *> : whole_arg<std::remove_cv_t<T>> {
+    static constexpr const void *address(T *arg) noexcept
+    {
+        return arg ? whole_arg<std::remove_cv_t<T>>::address(*arg) : nullptr;
+    }
+};
+
+template <typename T>
+using whole_arg_t = typename whole_arg<std::remove_cvref_t<T>>::type;
+
+/**
+ * True if an argument of type `T` is passed unchanged to every invoke and
+ * refers to an object of the type of the target, which may be the target.
+ */
+template <typename Target, typename T>
+inline constexpr bool reads_whole_target =
+    !Gettable<T> && std::same_as<whole_arg_t<T>, std::remove_cvref_t<Target>>;
+
+/**
+ * True if `arg` is `target` itself passed whole to every invoke. Pointers
+ * into the target and callables that capture it are not detected.
+ */
+template <typename Target, typename T>
+constexpr bool passes_whole_target(const Target& target, const T& arg) noexcept
+{
+    if constexpr (reads_whole_target<Target, T>) {
+        return whole_arg<std::remove_cvref_t<T>>::address(arg) ==
+               static_cast<const void *>(&target);
+    } else {
+        return false;
+    }
+}
+
+/**
+ * Performs the invokes in index order, assigning the result of the `I`-th
+ * invoke to the `I`-th element of `target` before the next one starts.
+ */
+template <std::size_t... Is, typename F, typename Target, typename... Args>
+constexpr void invoke_for_all_indices_inplace(std::index_sequence<Is...>,
+                                              F&& f, Target& target,
+                                              Args&&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    static_assert((... && !std::is_reference_v<
+                              std::tuple_element_t<Is, Target>>),
+                  "the elements of the target of invoke_forall_inplace "
+                  "cannot be references, which may alias each other");
+    static_assert(
+        (... && std::is_assignable_v<
+                    decltype(get_element<Is>(target)),
+                    invoke_at_result_t<arity, Is, F, Target&, Args...>>),
+        "the result of every invoke of invoke_forall_inplace has to be "
+        "assignable to the matching element of the target");
+
+    /* every invoke would read the elements overwritten by earlier ones */
+    if (passes_whole_target(target, f) ||
+        (... || passes_whole_target(target, args))) {
+        throw inplace_target_aliased{};
+    }
+
+    ((get_element<Is>(target) = invoke_at_wrapper<arity, Is>(
+          hooks, std::forward<F>(f), target, std::forward<Args>(args)...)),
+     ...);
+}
+
+/** Satisfied if `invoke_forall_inplace()` can write to `Target`. */
+template <typename Target>
+concept InplaceTarget = Gettable<Target&> && !std::is_const_v<Target>;
+
+} /* namespace detail */
+
+/**
+ * Performs the same invokes as `invoke_forall(f, target, args...)`, but
+ * instead of returning the results assigns the `i`-th one to the `i`-th
+ * element of `target` as soon as the `i`-th invoke returns, without an
+ * intermediate array. The `i`-th invoke gets the `i`-th element of `target`,
+ * and the invokes run in order, so an invoke sees the results of all earlier
+ * ones if it reaches `target` by other means.
+ *
+ * Results must be assignable to their element and the elements of `target`
+ * must not be references, which is checked at compile time. No argument
+ * may be `target` itself passed whole, as `protect_arg(target)`,
+ * `std::ref(target)` or `&target`; this is checked by address before the
+ * first invoke, which throws `inplace_target_aliased` or, in a constant
+ * expression, does not compile. Other objects of the same type are fine. A
+ * callable capturing `target` by reference, or an argument pointing into
+ * it, is not detected; the caller has to make sure such an invoke does not
+ * read an element that was already overwritten.
+ */
+INVOKE_FORALL_EXPORT template <typename F, typename Target, typename... Args>
+requires detail::InplaceTarget<Target> &&
+         detail::SameArity<F, Target&, Args...>
+constexpr void invoke_forall_inplace(F&& f, Target& target, Args&&...args)
+{
+    /* Not named like the public function, since ADL on `protect_arg()`
+       arguments would find both. */
+    detail::invoke_for_all_indices_inplace(
+        std::make_index_sequence<detail::invoke_count<F, Target&, Args...>>{},
+        std::forward<F>(f), target, std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_INPLACE_H */
@@ -0,0 +1,301 @@
+/**
+ * Memoization of pure callables passed to `invoke_forall`.
+ *
+ * `memoize_arg(f, options)` returns a callable that behaves like `f`, but
+ * looks the arguments up in a bounded, hash-keyed cache first and only
+ * calls `f` on a miss. The cache is shared by all copies of the returned
+ * callable (`invoke_forall` copies rvalue callables for all but the last
+ * invoke), is safe to use from multiple threads and keeps hit, miss and
+ * eviction counters.
+ *
+ * A separate cache is kept for every combination of argument types, so
+ * heterogeneous Gettable arguments can be memoized too. Arguments are
+ * decayed and copied into the key, so they have to be hashable with
+ * `std::hash` and equality comparable. Results are returned by value.
+ */
+
+#ifndef INVOKE_FORALL_MEMO_H
+#define INVOKE_FORALL_MEMO_H
+
+#include "invoke_forall.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** Which cached entry is dropped when a cache shard is full. */
+enum class eviction_policy {
+    /* Least recently used entry. */
+    lru,
+    /* Second-chance approximation of LRU, hits do not reorder entries. */
+    clock,
+};
+
+struct memo_options {
+    /* Maximum number of cached results per argument-type combination,
+       split exactly among the shards; `0` disables caching. */
+    std::size_t capacity = 1024;
+    eviction_policy eviction = eviction_policy::lru;
+    /* Number of independently locked parts of each cache, at most
+       `capacity`. */
+    std::size_t shards = 8;
+};
+
+struct memo_stats {
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+};
+
+namespace detail
+{
+
+/** Combines `std::hash` of all elements of a key tuple. */
+struct memo_key_hash {
+    template <typename... Ts>
+    std::size_t operator()(const std::tuple<Ts...>& key) const
+    {
+        std::size_t seed = 0;
+        std::apply(
+            [&](const auto&...elems) {
+                ((seed ^= std::hash<std::remove_cvref_t<decltype(elems)>>{}(
+                              elems) +
+                          0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)),
+                 ...);
+            },
+            key);
+        return seed;
+    }
+};
+
+/**
+ * A bounded map from `Key` to `Value` guarded by a single mutex.
+ *
+ * Entries are kept in a list. With LRU a hit moves the entry to the front
+ * and the back is evicted; with CLOCK a hit only sets the referenced bit and
+ * the hand sweeps the list, giving referenced entries a second chance.
+ */
+template <typename Key, typename Value>
+class memo_shard {
+public:
+    memo_shard(std::size_t capacity, eviction_policy policy)
+        : capacity(capacity), policy(policy), hand(entries.end())
+    {
+    }
+
+    std::optional<Value> find(const Key& key)
+    {
+        std::lock_guard lock(mutex);
+
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return std::nullopt;
+        }
+
+        if (policy == eviction_policy::lru) {
+            entries.splice(entries.begin(), entries, it->second);
+        } else {
+            it->second->referenced = true;
+        }
+        return it->second->value;
+    }
+
+    /** Inserts the entry unless present, returns the number of evictions. */
+    std::size_t insert(Key key, const Value& value)
+    {
+        std::lock_guard lock(mutex);
+
+        if (capacity == 0 || index.contains(key)) {
+            return 0;
+        }
+
+        std::size_t evicted = 0;
+        if (entries.size() >= capacity) {
+            evict();
+            evicted = 1;
+        }
+
+        auto pos = policy == eviction_policy::lru ? entries.begin() : hand;
+        auto it = entries.insert(pos, entry{ key, value, false });
+        index.emplace(std::move(key), it);
+
+        return evicted;
+    }
+
+private:
+    struct entry {
+        Key key;
+        Value value;
+        bool referenced;
+    };
+
+    using entry_list = std::list<entry>;
+
+    void evict()
+    {
+        typename entry_list::iterator victim;
+
+        if (policy == eviction_policy::lru) {
+            victim = std::prev(entries.end());
+        } else {
+            while (true) {
+                if (hand == entries.end()) {
+                    hand = entries.begin();
+                }
+                if (!hand->referenced) {
+                    break;
+                }
+                hand->referenced = false;
+                ++hand;
+            }
+            victim = hand++;
+        }
+
+        index.erase(victim->key);
+        entries.erase(victim);
+    }
+
+    std::mutex mutex;
+    std::size_t capacity;
+    eviction_policy policy;
+    entry_list entries;
+    typename entry_list::iterator hand;
+    std::unordered_map<Key, typename entry_list::iterator, memo_key_hash> index;
+};
+
+/**
+ * A cache split into shards by the hash of the key. The capacity is split
+ * exactly: the first `capacity % shards` shards hold one entry more than
+ * the others, and there are no more shards than entries.
+ */
+template <typename Key, typename Value>
+class memo_cache {
+public:
+    explicit memo_cache(const memo_options& options)
+    {
+        std::size_t count = std::clamp<std::size_t>(
+            options.shards, 1, std::max<std::size_t>(options.capacity, 1));
+        std::size_t per_shard = options.capacity / count;
+        std::size_t larger = options.capacity % count;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            shards.push_back(std::make_unique<memo_shard<Key, Value>>(
+                per_shard + (i < larger), options.eviction));
+        }
+    }
+
+    memo_shard<Key, Value>& shard_for(const Key& key)
+    {
+        return *shards[memo_key_hash{}(key) % shards.size()];
+    }
+
+private:
+    std::vector<std::unique_ptr<memo_shard<Key, Value>>> shards;
+};
+
+/** State shared by all copies of a memoized callable. */
+struct memo_state {
+    explicit memo_state(const memo_options& options) : options(options) {}
+
+    template <typename Key, typename Value>
+    memo_cache<Key, Value>& cache_for()
+    {
+        const std::type_index type = typeid(memo_cache<Key, Value>);
+
+        {
+            std::shared_lock lock(mutex);
+            auto it = caches.find(type);
+            if (it != caches.end()) {
+                return *static_cast<memo_cache<Key, Value> *>(it->second.get());
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        auto& cache = caches[type];
+        if (!cache) {
+            cache = std::make_shared<memo_cache<Key, Value>>(options);
+        }
+        return *static_cast<memo_cache<Key, Value> *>(cache.get());
+    }
+
+    memo_options options;
+    std::shared_mutex mutex;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> caches;
+    std::atomic<std::size_t> hits = 0;
+    std::atomic<std::size_t> misses = 0;
+    std::atomic<std::size_t> evictions = 0;
+};
+
+/** Callable returned by `memoize_arg()`. */
+template <typename F>
+class memoized {
+public:
+    memoized(F f, const memo_options& options)
+        : f(std::move(f)), state(std::make_shared<memo_state>(options))
+    {
+    }
+
+    template <typename... Ts>
+    auto operator()(Ts&&...ts) const
+    {
+        using result_type = std::invoke_result_t<const F&, Ts...>;
+        using key_type = std::tuple<std::decay_t<Ts>...>;
+
+        static_assert(!std::is_void_v<result_type> &&
+                          !std::is_reference_v<result_type>,
+                      "memoized callables have to return by value");
+
+        key_type key(ts...);
+        auto& shard =
+            state->template cache_for<key_type, result_type>().shard_for(key);
+
+        if (auto cached = shard.find(key)) {
+            state->hits.fetch_add(1, std::memory_order_relaxed);
+            return *std::move(cached);
+        }
+
+        state->misses.fetch_add(1, std::memory_order_relaxed);
+        result_type result = std::invoke(f, std::forward<Ts>(ts)...);
+        state->evictions.fetch_add(shard.insert(std::move(key), result),
+                                   std::memory_order_relaxed);
+        return result;
+    }
+
+    memo_stats stats() const
+    {
+        return { state->hits.load(), state->misses.load(),
+                 state->evictions.load() };
+    }
+
+private:
+    F f;
+    std::shared_ptr<memo_state> state;
+};
+
+} /* namespace detail */
+
+/**
+ * Wraps a pure callable `f` so that its results are cached, see the top of
+ * this file. `stats()` of the returned callable reports hits, misses and
+ * evictions of all its copies.
+ */
+template <typename F>
+detail::memoized<std::decay_t<F>> memoize_arg(F&& f, memo_options options = {})
+{
+    return { std::forward<F>(f), options };
+}
+
+#endif /* INVOKE_FORALL_MEMO_H */
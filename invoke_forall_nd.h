@@ -0,0 +1,378 @@
+/**
+ * Multi-dimensional `invoke_forall` over nested `std::array`s and
+ * static-extent `std::mdspan`s.
+ *
+ * `invoke_forall_nd(f, args...)` treats the nested extents of its array
+ * arguments as one index space: for every multi-index `(i0, ..., ik)` it
+ * performs `std::invoke(x1, ..., xn)`, where `xj = argj[i0]...[ik]` (or
+ * `argj[i0, ..., ik]` for an `std::mdspan`) if `argj` is an array argument,
+ * and `xj = argj` otherwise. The shapes of all array arguments are checked
+ * at compile time, and the results are returned by value in nested
+ * `std::array`s of the same shape, so they have to be default
+ * constructible; `void` results are stored as `std::monostate`, as in
+ * `invoke_forall`.
+ *
+ * Arguments wrapped with `protect_arg()` are unwrapped and passed to every
+ * invoke. Other tuple-like arguments can not be zipped with the index
+ * space and have to be wrapped with `protect_arg()` to be passed whole.
+ *
+ * The rank of the index space is the smallest nesting depth of the array
+ * arguments, or `Rank` if given explicitly; deeper elements are passed to
+ * the callable as they are. Elements are visited in row-major order,
+ * column-major order or, by default, in tiles small enough for the
+ * arguments and results of a tile to stay in the L1 cache.
+ */
+
+#ifndef INVOKE_FORALL_ND_H
+#define INVOKE_FORALL_ND_H
+
+#include "invoke_forall.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#if __has_include(<mdspan>)
+#include <mdspan>
+#endif
+
+enum class nd_order {
+    /* The last index changes fastest. */
+    row_major,
+    /* The first index changes fastest. */
+    column_major,
+    /* Row-major order of tiles, row-major order inside every tile. */
+    tiled,
+};
+
+struct nd_options {
+    nd_order order = nd_order::tiled;
+    /* Side of a tile, `0` picks one from the size of the elements. */
+    std::size_t tile = 0;
+};
+
+namespace detail
+{
+
+/** Bytes of a tile that should fit into the L1 data cache. */
+inline constexpr std::size_t nd_tile_bytes = 16 * 1024;
+
+/**
+ * Shape of an argument: `rank` nested extents for array arguments, none
+ * for arguments passed to every invoke unchanged.
+ */
+template <typename T>
+struct nd_shape {
+    static constexpr std::size_t rank = 0;
+    static constexpr std::array<std::size_t, 0> extents{};
+    using element_type = T;
+};
+
+template <typename T, std::size_t N>
+struct nd_shape<std::array<T, N>> {
+    static constexpr std::size_t rank = 1 + nd_shape<T>::rank;
+
+    static constexpr auto extents = [] {
+        std::array<std::size_t, rank> result{ N };
+        std::ranges::copy(nd_shape<T>::extents, result.begin() + 1);
+        return result;
+    }();
+
+    using element_type = typename nd_shape<T>::element_type;
+};
+
+template <typename T>
+inline constexpr bool is_mdspan = false;
+
+#ifdef __cpp_lib_mdspan
+template <typename T, typename I, std::size_t... Es, typename L, typename A>
+requires(... && (Es != std::dynamic_extent))
+struct nd_shape<std::mdspan<T, std::extents<I, Es...>, L, A>> {
+    static constexpr std::size_t rank = sizeof...(Es);
+    static constexpr std::array<std::size_t, rank> extents{ Es... };
+    using element_type = T;
+};
+
+template <typename T, typename E, typename L, typename A>
+inline constexpr bool is_mdspan<std::mdspan<T, E, L, A>> = true;
+#endif
+
+template <typename T>
+inline constexpr std::size_t nd_rank = nd_shape<std::remove_cvref_t<T>>::rank;
+
+/** Rank of the index space: the smallest nonzero rank of the arguments. */
+template <typename... Args>
+inline constexpr std::size_t nd_min_rank = [] {
+    std::size_t rank = 0;
+    ((rank = nd_rank<Args> == 0 ? rank
+             : rank == 0        ? nd_rank<Args>
+                                : std::min(rank, nd_rank<Args>)),
+     ...);
+    return rank;
+}();
+
+/** The first `Rank` extents of `T`. */
+template <std::size_t Rank, typename T>
+constexpr std::array<std::size_t, Rank> nd_extents()
+{
+    std::array<std::size_t, Rank> result{};
+    std::ranges::copy_n(nd_shape<std::remove_cvref_t<T>>::extents.begin(),
+                        Rank, result.begin());
+    return result;
+}
+
+/** True if all array arguments have the same first `Rank` extents. */
+template <std::size_t Rank, typename... Args>
+inline constexpr bool nd_same_extents = [] {
+    std::array<std::size_t, Rank> first{};
+    bool found = false;
+    bool same = true;
+
+    auto check = [&]<typename T>() {
+        if constexpr (nd_rank<T> != 0) {
+            auto extents = nd_extents<Rank, T>();
+            same = same && (!found || extents == first);
+            first = extents;
+            found = true;
+        }
+    };
+    (check.template operator()<Args>(), ...);
+
+    return same;
+}();
+
+/** Extents of the first array argument. */
+template <std::size_t Rank, typename T, typename... Ts>
+constexpr std::array<std::size_t, Rank> nd_common_extents()
+{
+    if constexpr (nd_rank<T> != 0) {
+        return nd_extents<Rank, T>();
+    } else {
+        return nd_common_extents<Rank, Ts...>();
+    }
+}
+
+/** Element of `arg` at the first `Rank - D` indices of `idx` from `D` on. */
+template <std::size_t D, std::size_t Rank, typename T>
+constexpr decltype(auto) nd_at(T& arg, const std::array<std::size_t, Rank>& idx)
+{
+    using U = std::remove_cvref_t<T>;
+
+    if constexpr (Protected<U>) {
+        return (arg.value);
+    } else if constexpr (nd_rank<U> == 0) {
+        return (arg);
+    } else if constexpr (is_mdspan<U>) {
+        return [&]<std::size_t... Ks>(std::index_sequence<Ks...>)
+                   -> decltype(auto) {
+            return arg[idx[Ks]...];
+        }(std::make_index_sequence<Rank>{});
+    } else if constexpr (D + 1 == Rank) {
+        return (arg[idx[D]]);
+    } else {
+        return nd_at<D + 1>(arg[idx[D]], idx);
+    }
+}
+
+template <std::size_t Rank, typename T>
+using nd_at_t = decltype(nd_at<0>(
+    std::declval<T&>(), std::declval<std::array<std::size_t, Rank>>()));
+
+/**
+ * Performs `std::invoke(xs...)` without zipping any of `xs`, returning
+ * `std::monostate` instead of `void` like `invoke_at()`.
+ */
+template <typename... Ts>
+constexpr decltype(auto) nd_invoke(Ts&&...xs)
+{
+    if constexpr (std::is_void_v<decltype(std::invoke(
+                      std::forward<Ts>(xs)...))>) {
+        std::invoke(std::forward<Ts>(xs)...);
+        return std::monostate{};
+    } else {
+        return std::invoke(std::forward<Ts>(xs)...);
+    }
+}
+
+template <typename... Ts>
+using nd_value_t =
+    std::remove_cvref_t<decltype(nd_invoke(std::declval<Ts>()...))>;
+
+/** Nested `std::array`s of `T` with the given extents. */
+template <typename T, std::size_t... Es>
+struct nd_array;
+
+template <typename T>
+struct nd_array<T> {
+    using type = T;
+};
+
+template <typename T, std::size_t E, std::size_t... Es>
+struct nd_array<T, E, Es...> {
+    using type = std::array<typename nd_array<T, Es...>::type, E>;
+};
+
+template <typename T, auto Extents, typename Is>
+struct nd_result;
+
+template <typename T, auto Extents, std::size_t... Is>
+struct nd_result<T, Extents, std::index_sequence<Is...>> {
+    using type = typename nd_array<T, Extents[Is]...>::type;
+};
+
+template <typename T, auto Extents>
+using nd_result_t = typename nd_result<
+    T, Extents, std::make_index_sequence<Extents.size()>>::type;
+
+/**
+ * Visits every multi-index in the box `[lo, hi)`, with the dimensions
+ * nested in the order given by `dims` (outermost first).
+ */
+template <std::size_t L, std::size_t Rank, typename Body>
+constexpr void nd_loop(const std::array<std::size_t, Rank>& dims,
+                       const std::array<std::size_t, Rank>& lo,
+                       const std::array<std::size_t, Rank>& hi,
+                       std::array<std::size_t, Rank>& idx, Body& body)
+{
+    if constexpr (L == Rank) {
+        body(idx);
+    } else {
+        std::size_t d = dims[L];
+        for (idx[d] = lo[d]; idx[d] < hi[d]; ++idx[d]) {
+            nd_loop<L + 1>(dims, lo, hi, idx, body);
+        }
+    }
+}
+
+/** Largest tile side whose tile of `bytes` large elements fits in L1. */
+template <std::size_t Rank>
+constexpr std::size_t nd_auto_tile(std::size_t bytes)
+{
+    auto volume = [](std::size_t side) {
+        std::size_t v = 1;
+        for (std::size_t d = 0; d < Rank; ++d) {
+            v *= side;
+        }
+        return v;
+    };
+
+    std::size_t side = 1;
+    while (volume(side + 1) * bytes <= nd_tile_bytes) {
+        ++side;
+    }
+    return side;
+}
+
+/** Visits every index of `extents` in the order given by `options`. */
+template <std::size_t Rank, typename Body>
+constexpr void nd_for_each(const std::array<std::size_t, Rank>& extents,
+                           nd_options options, std::size_t element_bytes,
+                           Body body)
+{
+    std::array<std::size_t, Rank> dims{};
+    for (std::size_t d = 0; d < Rank; ++d) {
+        dims[d] = options.order == nd_order::column_major ? Rank - 1 - d : d;
+    }
+
+    std::array<std::size_t, Rank> zero{};
+    std::array<std::size_t, Rank> idx{};
+
+    if (options.order != nd_order::tiled || Rank < 2) {
+        nd_loop<0>(dims, zero, extents, idx, body);
+        return;
+    }
+
+    std::size_t tile = options.tile != 0 ? options.tile
+                                         : nd_auto_tile<Rank>(element_bytes);
+
+    std::array<std::size_t, Rank> tiles{};
+    for (std::size_t d = 0; d < Rank; ++d) {
+        tiles[d] = (extents[d] + tile - 1) / tile;
+    }
+
+    std::array<std::size_t, Rank> tile_idx{};
+    auto visit_tile = [&](const std::array<std::size_t, Rank>& t) {
+        std::array<std::size_t, Rank> lo{};
+        std::array<std::size_t, Rank> hi{};
+        for (std::size_t d = 0; d < Rank; ++d) {
+            lo[d] = t[d] * tile;
+            hi[d] = std::min(extents[d], lo[d] + tile);
+        }
+        nd_loop<0>(dims, lo, hi, idx, body);
+    };
+    nd_loop<0>(dims, zero, tiles, tile_idx, visit_tile);
+}
+
+template <std::size_t Rank, typename... Args>
+constexpr auto invoke_forall_nd(nd_options options, Args&...args)
+{
+    static_assert(Rank > 0, "invoke_forall_nd needs at least one nested "
+                            "std::array or static-extent std::mdspan");
+    static_assert((... && (nd_rank<Args> == 0 || nd_rank<Args> >= Rank)),
+                  "invoke_forall_nd arguments have a smaller rank than "
+                  "requested");
+    static_assert((... && (!is_mdspan<std::remove_cvref_t<Args>> ||
+                           nd_rank<Args> == Rank)),
+                  "std::mdspan arguments have to have exactly the requested "
+                  "rank");
+    static_assert(nd_same_extents<Rank, Args...>,
+                  "invoke_forall_nd arguments have different shapes");
+    static_assert((... && (nd_rank<Args> != 0 || !Gettable<Args>)),
+                  "tuple-like arguments of invoke_forall_nd that are not "
+                  "std::arrays have to be wrapped with protect_arg()");
+
+    constexpr auto extents = nd_common_extents<Rank, Args...>();
+
+    using value_type = nd_value_t<nd_at_t<Rank, Args>...>;
+    using result_type = nd_result_t<value_type, extents>;
+
+    static_assert(std::is_default_constructible_v<value_type>,
+                  "invoke_forall_nd stores its results in nested std::arrays "
+                  "and requires a default constructible result type");
+
+    constexpr std::size_t element_bytes =
+        sizeof(value_type) +
+        (... + (nd_rank<Args> == 0
+                    ? 0
+                    : sizeof(std::remove_cvref_t<nd_at_t<Rank, Args>>)));
+
+    result_type result{};
+
+    nd_for_each(extents, options, element_bytes,
+                [&](const std::array<std::size_t, Rank>& idx) {
+        nd_at<0>(result, idx) = nd_invoke(nd_at<0>(args, idx)...);
+    });
+
+    return result;
+}
+
+} /* namespace detail */
+
+/**
+ * Performs an invoke for every multi-index of the common shape of the array
+ * arguments, see the top of this file. `Rank` selects the number of nested
+ * levels to zip, `0` means the smallest rank of the array arguments.
+ */
+template <std::size_t Rank = 0, typename... Args>
+requires detail::NonEmpty<Args...>
+constexpr auto invoke_forall_nd(nd_options options, Args&&...args)
+{
+    constexpr std::size_t rank =
+        Rank != 0 ? Rank : detail::nd_min_rank<Args...>;
+
+    return detail::invoke_forall_nd<rank>(options, args...);
+}
+
+/** Same as above, traversing the elements in cache-sized tiles. */
+template <std::size_t Rank = 0, typename... Args>
+requires detail::NonEmpty<Args...>
+constexpr auto invoke_forall_nd(Args&&...args)
+{
+    return invoke_forall_nd<Rank>(nd_options{}, std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_ND_H */
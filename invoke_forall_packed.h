@@ -0,0 +1,225 @@
+/**
+ * Bit-packed `bool` results of `invoke_forall`.
+ *
+ * `invoke_forall_packed` packs `bool` results into the bits of a
+ * `packed_bools`.
+ */
+
+#ifndef INVOKE_FORALL_PACKED_H
+#define INVOKE_FORALL_PACKED_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * `N` bools packed into 64-bit words, returned by `invoke_forall_packed()`.
+ * Bits past `N` in the last word are always zero. Like `std::array<bool, N>`
+ * it is Gettable, with `get<I>` returning the `I`-th bool by value, both as
+ * a member and found by argument-dependent lookup.
+ */
+INVOKE_FORALL_EXPORT template <std::size_t N>
+class packed_bools {
+public:
+    using word_type = std::uint64_t;
+
+    static constexpr std::size_t word_bits = 64;
+    static constexpr std::size_t word_count = (N + word_bits - 1) / word_bits;
+
+    constexpr packed_bools() = default;
+
+    static constexpr std::size_t size() noexcept { return N; }
+
+    constexpr bool test(std::size_t i) const noexcept
+    {
+        return (bits[i / word_bits] >> (i % word_bits)) & 1;
+    }
+
+    constexpr bool operator[](std::size_t i) const noexcept { return test(i); }
+
+    constexpr void set(std::size_t i, bool value = true) noexcept
+    {
+        word_type mask = word_type{ 1 } << (i % word_bits);
+        bits[i / word_bits] = value ? bits[i / word_bits] | mask
+                                    : bits[i / word_bits] & ~mask;
+    }
+
+    template <std::size_t I>
+    requires(I < N)
+    constexpr bool get() const noexcept
+    {
+        return test(I);
+    }
+
+    template <std::size_t I>
+    requires(I < N)
+    friend constexpr bool get(const packed_bools& bits) noexcept
+    {
+        return bits.test(I);
+    }
+
+    /** Number of set bits, one `std::popcount` per word. */
+    constexpr std::size_t count() const noexcept
+    {
+        std::size_t result = 0;
+        for (word_type word : bits) {
+            result += static_cast<std::size_t>(std::popcount(word));
+        }
+        return result;
+    }
+
+    constexpr bool any() const noexcept
+    {
+        for (word_type word : bits) {
+            if (word != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr bool none() const noexcept { return !any(); }
+
+    constexpr bool all() const noexcept
+    {
+        for (std::size_t w = 0; w < word_count; ++w) {
+            if (bits[w] != word_mask(w)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** The packed words, bit `i` is bit `i % 64` of word `i / 64`. */
+    constexpr const std::array<word_type, word_count>& words() const noexcept
+    {
+        return bits;
+    }
+
+    constexpr packed_bools& operator&=(const packed_bools& other) noexcept
+    {
+        for (std::size_t w = 0; w < word_count; ++w) {
+            bits[w] &= other.bits[w];
+        }
+        return *this;
+    }
+
+    constexpr packed_bools& operator|=(const packed_bools& other) noexcept
+    {
+        for (std::size_t w = 0; w < word_count; ++w) {
+            bits[w] |= other.bits[w];
+        }
+        return *this;
+    }
+
+    constexpr packed_bools& operator^=(const packed_bools& other) noexcept
+    {
+        for (std::size_t w = 0; w < word_count; ++w) {
+            bits[w] ^= other.bits[w];
+        }
+        return *this;
+    }
+
+    constexpr packed_bools operator~() const noexcept
+    {
+        packed_bools result;
+        for (std::size_t w = 0; w < word_count; ++w) {
+            result.bits[w] = ~bits[w] & word_mask(w);
+        }
+        return result;
+    }
+
+    friend constexpr packed_bools operator&(packed_bools lhs,
+                                            const packed_bools& rhs) noexcept
+    {
+        return lhs &= rhs;
+    }
+
+    friend constexpr packed_bools operator|(packed_bools lhs,
+                                            const packed_bools& rhs) noexcept
+    {
+        return lhs |= rhs;
+    }
+
+    friend constexpr packed_bools operator^(packed_bools lhs,
+                                            const packed_bools& rhs) noexcept
+    {
+        return lhs ^= rhs;
+    }
+
+    constexpr bool operator==(const packed_bools&) const = default;
+
+private:
+    /** Bits of word `w` that hold one of the `N` bools. */
+    static constexpr word_type word_mask(std::size_t w) noexcept
+    {
+        std::size_t used = w + 1 < word_count || N % word_bits == 0
+                               ? word_bits
+                               : N % word_bits;
+        return used == word_bits ? ~word_type{ 0 }
+                                 : (word_type{ 1 } << used) - 1;
+    }
+
+    std::array<word_type, word_count> bits{};
+};
+
+template <std::size_t N>
+struct std::tuple_size<packed_bools<N>>
+    : std::integral_constant<std::size_t, N> {};
+
+template <std::size_t I, std::size_t N>
+struct std::tuple_element<I, packed_bools<N>> {
+    using type = bool;
+};
+
+namespace detail
+{
+
+/** Sets bit `I` of `bits` to the result of the `I`-th invoke. */
+template <std::size_t... Is, typename... Args>
+constexpr auto invoke_for_all_indices_packed(std::index_sequence<Is...>,
+                                             Args&&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+    no_hooks hooks;
+
+    static_assert(
+        (... && std::same_as<
+                    std::remove_cvref_t<invoke_at_result_t<arity, Is, Args...>>,
+                    bool>),
+        "all invokes of invoke_forall_packed have to return bool");
+
+    packed_bools<arity> bits;
+    (bits.set(Is, invoke_at_wrapper<arity, Is>(hooks,
+                                               std::forward<Args>(args)...)),
+     ...);
+    return bits;
+}
+
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_packed(Args&&...args)
+{
+    return invoke_for_all_indices_packed(
+        std::make_index_sequence<invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)` for invokes that all return `bool`, but
+ * packs the results into the bits of a `packed_bools`.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_packed(Args&&...args)
+{
+    return detail::invoke_forall_packed(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_PACKED_H */
@@ -0,0 +1,1091 @@
+/**
+ * Concurrent execution of the invokes performed by `invoke_forall`.
+ *
+ * Provides execution policies `sequenced` and `parallel` (which runs the
+ * invokes on a `thread_pool`), the overload `invoke_forall(policy, args...)`
+ * that returns the same result as `invoke_forall(args...)`, and
+ * `invoke_forall_async(policy, args...)` that returns a `result_stream`
+ * right away. Each slot of the stream is published with release semantics
+ * as soon as its invoke finishes, so consumers can poll or wait for single
+ * indices without locks while the remaining invokes are still running.
+ *
+ * The `adaptive` policy measures the time of a single invoke and uses it to
+ * choose between running the invokes on the calling thread and running them
+ * on the pool, together with the number of invokes per task. On the calling
+ * thread, invokes over arrays of arithmetic values run through the
+ * vectorized kernels of `invoke_forall_simd`. Without explicit
+ * `adaptive_stats` the measurements are kept per combination of argument
+ * types and the place where the `adaptive_policy` object was created.
+ *
+ * `invoke_forall_scan(policy, op, args...)` computes the prefix scans of the
+ * results with a two-pass scan over chunks of consecutive invokes.
+ *
+ * `invoke_forall_padded(policy, args...)` stores every result in its own
+ * cache-line-aligned slot, so that invokes running on different threads do
+ * not write to the same cache line.
+ *
+ * Invokes may run concurrently, so arguments are never moved from by one
+ * invoke while another one may still use them: rvalue Gettable arguments
+ * pass their (distinct) elements as rvalues, all other arguments are passed
+ * as lvalues. Concurrent calls of the same callable have to be safe.
+ */
+
+#ifndef INVOKE_FORALL_PARALLEL_H
+#define INVOKE_FORALL_PARALLEL_H
+
+#include "invoke_forall.h"
+#include "invoke_forall_scan.h"
+#include "invoke_forall_simd.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <source_location>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** A fixed set of worker threads executing submitted tasks in FIFO order. */
+class thread_pool {
+public:
+    explicit thread_pool(std::size_t threads = default_size())
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /** Finishes all queued tasks and joins the workers. */
+    ~thread_pool()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    std::size_t size() const { return workers.size(); }
+
+    /** Pool shared by the policies that do not name their own pool. */
+    static thread_pool& default_pool()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+private:
+    static std::size_t default_size()
+    {
+        return std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    void work()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+/** Runs every invoke on the calling thread, in index order. */
+struct sequenced_policy {
+    using is_execution_policy_tag = void;
+
+    template <typename F>
+    void execute(F&& task) const
+    {
+        std::forward<F>(task)();
+    }
+};
+
+/**
+ * Runs the invokes as tasks of `pool`, or of the default pool, each task
+ * performing `grain` consecutive invokes.
+ */
+struct parallel_policy {
+    using is_execution_policy_tag = void;
+
+    thread_pool *pool = nullptr;
+    std::size_t grain = 1;
+
+    template <typename F>
+    void execute(F&& task) const
+    {
+        (pool ? *pool : thread_pool::default_pool())
+            .submit(std::forward<F>(task));
+    }
+};
+
+inline constexpr sequenced_policy sequenced{};
+inline constexpr parallel_policy parallel{};
+
+namespace detail
+{
+
+/** Satisfied if `T` is an execution policy of this module. */
+template <typename T>
+concept ExecutionPolicy =
+    requires { typename std::remove_cvref_t<T>::is_execution_policy_tag; };
+
+/**
+ * Type under which a result of type `R` is stored in a `result_stream`:
+ * lvalue references are stored as `std::reference_wrapper`.
+ */
+template <typename R>
+using stored_result_t = std::conditional_t<
+    std::is_lvalue_reference_v<R>,
+    std::reference_wrapper<std::remove_reference_t<R>>,
+    std::remove_cvref_t<R>>;
+
+/**
+ * Forwards an argument stored with type `T` to an invoke that may run
+ * concurrently with the other invokes: only Gettable rvalues are moved.
+ */
+template <typename T>
+constexpr decltype(auto) forward_concurrent(std::remove_reference_t<T>& t)
+{
+    if constexpr (Gettable<T> && !std::is_lvalue_reference_v<T>) {
+        return std::move(t);
+    } else {
+        return (t);
+    }
+}
+
+template <typename T>
+using concurrent_arg_t = decltype(forward_concurrent<T>(
+    std::declval<std::remove_reference_t<T>&>()));
+
+template <typename... Rs>
+inline constexpr bool same_results = [] {
+    if constexpr (sizeof...(Rs) == 0) {
+        return false;
+    } else {
+        using first = std::tuple_element_t<0, std::tuple<Rs...>>;
+        return (... && std::same_as<first, Rs>);
+    }
+}();
+
+enum class slot_state : unsigned char { pending, ready, failed };
+
+/**
+ * Minimal distance between objects written by different threads. It is part
+ * of the layout of `padded`, so code sharing these types across translation
+ * units built with different `-mtune` flags should fix it by defining
+ * `INVOKE_FORALL_CACHE_LINE`.
+ */
+#if defined(INVOKE_FORALL_CACHE_LINE)
+inline constexpr std::size_t cache_line_size = INVOKE_FORALL_CACHE_LINE;
+#elif defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr std::size_t cache_line_size =
+    std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr std::size_t cache_line_size = 64;
+#endif
+
+} /* namespace detail */
+
+/**
+ * Results of `invoke_forall_async()`: one slot per invoke, where `Rs` are
+ * the result types of the invokes.
+ *
+ * Producers fill each slot once with `produce<I>()`, consumers observe it
+ * with `ready()`, `wait()` and `get<I>()`. If all invokes have the same
+ * result type, slots can also be accessed with a runtime index.
+ */
+template <typename... Rs>
+class result_stream {
+public:
+    static constexpr std::size_t size = sizeof...(Rs);
+
+    /** True if all results have the same type. */
+    static constexpr bool homogeneous = detail::same_results<Rs...>;
+
+    /** Result type of the `I`-th invoke. */
+    template <std::size_t I>
+    using result_type = std::tuple_element_t<I, std::tuple<Rs...>>;
+
+    /** Type under which the `I`-th result is stored. */
+    template <std::size_t I>
+    using value_type = detail::stored_result_t<result_type<I>>;
+
+    result_stream() = default;
+
+    result_stream(const result_stream&) = delete;
+    result_stream& operator=(const result_stream&) = delete;
+
+    /** True once the `i`-th invoke has finished, successfully or not. */
+    bool ready(std::size_t i) const noexcept
+    {
+        return states[i].load(std::memory_order_acquire) !=
+               detail::slot_state::pending;
+    }
+
+    /** Blocks until the `i`-th invoke has finished. */
+    void wait(std::size_t i) const noexcept
+    {
+        states[i].wait(detail::slot_state::pending, std::memory_order_acquire);
+    }
+
+    void wait_all() const noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            wait(i);
+        }
+    }
+
+    /**
+     * Waits for the `I`-th result and returns it, or rethrows the exception
+     * thrown by the `I`-th invoke.
+     */
+    template <std::size_t I>
+    const value_type<I>& get() const
+    {
+        wait(I);
+        rethrow_if_failed(I);
+        return *std::get<I>(values);
+    }
+
+    /** Returns the `I`-th result if it is already available. */
+    template <std::size_t I>
+    const value_type<I> *try_get() const noexcept
+    {
+        if (states[I].load(std::memory_order_acquire) !=
+            detail::slot_state::ready) {
+            return nullptr;
+        }
+        return &*std::get<I>(values);
+    }
+
+    const value_type<0>& operator[](std::size_t i) const
+    requires homogeneous
+    {
+        wait(i);
+        rethrow_if_failed(i);
+        return *values[i];
+    }
+
+    /** Runs `f` and publishes its result or exception in the `I`-th slot. */
+    template <std::size_t I, typename F>
+    void produce(F&& f) noexcept
+    {
+        auto state = detail::slot_state::ready;
+        try {
+            std::get<I>(values).emplace(std::forward<F>(f)());
+        } catch (...) {
+            errors[I] = std::current_exception();
+            state = detail::slot_state::failed;
+        }
+
+        states[I].store(state, std::memory_order_release);
+        states[I].notify_all();
+    }
+
+    /** Moves the `I`-th result out of the stream, which has to be ready. */
+    template <std::size_t I>
+    value_type<I> take()
+    {
+        rethrow_if_failed(I);
+        return std::move(*std::get<I>(values));
+    }
+
+    /** Rethrows the exception of the invoke with the lowest failed index. */
+    void rethrow_first_error() const
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            rethrow_if_failed(i);
+        }
+    }
+
+private:
+    void rethrow_if_failed(std::size_t i) const
+    {
+        if (states[i].load(std::memory_order_acquire) ==
+            detail::slot_state::failed) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+
+    using storage_type = std::conditional_t<
+        homogeneous, std::array<std::optional<value_type<0>>, size>,
+        std::tuple<std::optional<detail::stored_result_t<Rs>>...>>;
+
+    storage_type values;
+    std::array<std::exception_ptr, size> errors;
+    std::array<std::atomic<detail::slot_state>, size> states{};
+};
+
+/** A value that does not share a cache line with any other object. */
+template <typename T>
+struct alignas(detail::cache_line_size) padded {
+    T value;
+};
+
+/**
+ * Results of `invoke_forall_padded()`: `N` values of type `T`, each in its
+ * own cache-line-aligned slot. `compact()` copies them into a plain
+ * `std::array<T, N>`.
+ */
+template <typename T, std::size_t N>
+class padded_results {
+public:
+    static constexpr std::size_t size() { return N; }
+
+    T& operator[](std::size_t i) { return slots[i].value; }
+    const T& operator[](std::size_t i) const { return slots[i].value; }
+
+    std::array<T, N> compact() const&
+    {
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<T, N>{ slots[Is].value... };
+        }(std::make_index_sequence<N>{});
+    }
+
+    std::array<T, N> compact() &&
+    {
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<T, N>{ std::move(slots[Is].value)... };
+        }(std::make_index_sequence<N>{});
+    }
+
+private:
+    std::array<padded<T>, N> slots{};
+};
+
+namespace detail
+{
+
+/** A `result_stream` together with the arguments its invokes read. */
+template <typename Stream, typename... Args>
+struct async_state : Stream {
+    std::tuple<Args...> args;
+
+    template <typename... Ts>
+    explicit async_state(Ts&&...ts) : args(std::forward<Ts>(ts)...)
+    {
+    }
+};
+
+/** Performs the `I`-th out of `A` invokes on the stored arguments. */
+template <std::size_t A, std::size_t I, typename... Args>
+decltype(auto) invoke_stored(std::tuple<Args...>& args)
+{
+    return [&]<std::size_t... Js>(std::index_sequence<Js...>)
+               -> decltype(auto) {
+        no_hooks hooks;
+        return invoke_at_wrapper<A, I>(
+            hooks, forward_concurrent<Args>(std::get<Js>(args))...);
+    }(std::index_sequence_for<Args...>{});
+}
+
+template <std::size_t A, typename Is, typename... Args>
+struct async_stream;
+
+template <std::size_t A, std::size_t... Is, typename... Args>
+struct async_stream<A, std::index_sequence<Is...>, Args...> {
+    using type = result_stream<
+        invoke_at_result_t<A, Is, concurrent_arg_t<Args>...>...>;
+};
+
+template <typename... Args>
+using async_stream_t =
+    typename async_stream<invoke_count<Args...>,
+                          std::make_index_sequence<invoke_count<Args...>>,
+                          Args...>::type;
+
+/**
+ * Number of consecutive invokes out of `n` per task of `policy`: its
+ * `grain` if it has one, all of them otherwise.
+ */
+template <typename Policy>
+std::size_t policy_grain(const Policy& policy, std::size_t n)
+{
+    if constexpr (requires { policy.grain; }) {
+        return std::max<std::size_t>(policy.grain, 1);
+    } else {
+        return std::max<std::size_t>(n, 1);
+    }
+}
+
+template <typename Policy, std::size_t... Is, typename... Args>
+std::shared_ptr<async_stream_t<Args...>>
+launch_async(const Policy& policy, std::index_sequence<Is...>, Args&&...args)
+{
+    constexpr std::size_t arity = sizeof...(Is);
+
+    using stream_type = async_stream_t<Args...>;
+    using state_type = async_state<stream_type, Args...>;
+
+    auto state = std::make_shared<state_type>(std::forward<Args>(args)...);
+
+    static constexpr std::array<void (*)(state_type&), arity> produce_at{
+        [](state_type& st) {
+            st.template produce<Is>([&]() -> decltype(auto) {
+                return invoke_stored<arity, Is>(st.args);
+            });
+        }...
+    };
+
+    std::size_t grain = policy_grain(policy, arity);
+
+    for (std::size_t begin = 0; begin < arity; begin += grain) {
+        std::size_t end = std::min(arity, begin + grain);
+        policy.execute([state, begin, end] {
+            for (std::size_t i = begin; i < end; ++i) {
+                produce_at[i](*state);
+            }
+        });
+    }
+
+    return state;
+}
+
+/** Number of threads that run the tasks of `policy`. */
+template <typename Policy>
+std::size_t policy_threads(const Policy& policy)
+{
+    if constexpr (requires { policy.pool; }) {
+        return (policy.pool ? *policy.pool : thread_pool::default_pool())
+            .size();
+    } else {
+        return 1;
+    }
+}
+
+/**
+ * Runs `body(begin, end)` over chunks of `[0, n)` according to `policy`
+ * and waits for all of them. Rethrows the exception of the first failed
+ * chunk.
+ */
+template <typename Policy, typename Body>
+void for_each_chunk(const Policy& policy, std::size_t n, std::size_t grain,
+                    Body body)
+{
+    std::size_t chunks = (n + grain - 1) / grain;
+    if (chunks == 0) {
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(chunks);
+    std::latch done(static_cast<std::ptrdiff_t>(chunks));
+
+    for (std::size_t c = 0; c < chunks; ++c) {
+        policy.execute([&, c] {
+            try {
+                body(c * grain, std::min(n, (c + 1) * grain));
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+template <typename Stream, std::size_t... Is>
+auto take_all(Stream& stream, std::index_sequence<Is...>)
+{
+    if constexpr (Stream::homogeneous) {
+        using first_result_type = typename Stream::template result_type<0>;
+
+        return std::array<
+            std::conditional_t<std::is_lvalue_reference_v<first_result_type>,
+                               typename Stream::template value_type<0>,
+                               std::remove_reference_t<first_result_type>>,
+            sizeof...(Is)>{ stream.template take<Is>()... };
+    } else {
+        return std::tuple<std::conditional_t<
+            std::is_lvalue_reference_v<
+                typename Stream::template result_type<Is>>,
+            typename Stream::template result_type<Is>,
+            typename Stream::template value_type<Is>>...>{
+            stream.template take<Is>()...
+        };
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * Starts the invokes of `invoke_forall(args...)` according to `policy` and
+ * returns a stream of their results. Lvalue arguments are referenced and
+ * have to outlive the invokes, rvalue arguments are moved into the stream.
+ */
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...>
+auto invoke_forall_async(const Policy& policy, Args&&...args)
+{
+    return detail::launch_async(
+        policy, std::make_index_sequence<detail::invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+/**
+ * Same as `invoke_forall(args...)`, but the invokes are run according to
+ * `policy`. If some invokes throw, the exception of the one with the lowest
+ * index is rethrown after all of them have finished.
+ */
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...>
+decltype(auto) invoke_forall(Policy&& policy, Args&&...args)
+{
+    if constexpr (detail::NoneGettable<Args...>) {
+        return invoke_forall(std::forward<Args>(args)...);
+    } else {
+        auto stream = invoke_forall_async(policy, std::forward<Args>(args)...);
+        stream->wait_all();
+        stream->rethrow_first_error();
+
+        using stream_type = std::remove_reference_t<decltype(*stream)>;
+
+        return detail::take_all(
+            *stream, std::make_index_sequence<stream_type::size>{});
+    }
+}
+
+namespace detail
+{
+
+/**
+ * Performs the invokes according to `policy` and assigns the `i`-th result
+ * to `results[i]` of a default constructed `Results`, which is
+ * `padded_results` for `invoke_forall_padded()`. Benchmarks instantiate it
+ * with a plain `std::array` to measure the effect of the padding alone.
+ */
+template <template <typename, std::size_t> typename Results, typename Policy,
+          typename... Args>
+auto invoke_forall_slots(const Policy& policy, Args&&...args)
+{
+    constexpr std::size_t arity = invoke_count<Args...>;
+
+    using stream_type = async_stream_t<Args...>;
+    static_assert(stream_type::homogeneous,
+                  "invoke_forall_padded requires all invokes to return the "
+                  "same type");
+
+    using value_type = typename stream_type::template value_type<0>;
+    static_assert(std::is_default_constructible_v<value_type>,
+                  "invoke_forall_padded requires a default constructible "
+                  "result type");
+
+    using results_type = Results<value_type, arity>;
+    using args_type = std::tuple<Args&&...>;
+
+    static constexpr auto produce_at =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<void (*)(results_type&, args_type&), arity>{
+                [](results_type& out, args_type& refs) {
+                    out[Is] = invoke_stored<arity, Is>(refs);
+                }...
+            };
+        }(std::make_index_sequence<arity>{});
+
+    std::size_t grain = policy_grain(policy, arity);
+
+    results_type results{};
+    args_type refs(std::forward<Args>(args)...);
+
+    for_each_chunk(policy, arity, grain,
+                   [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            produce_at[i](results, refs);
+        }
+    });
+
+    return results;
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(policy, args...)`, but every result is written
+ * into its own cache line of the returned `padded_results`, so concurrent
+ * invokes do not contend for the lines holding their neighbours' results.
+ * All invokes have to return the same default constructible type.
+ */
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...> && (!detail::NoneGettable<Args...>)
+auto invoke_forall_padded(const Policy& policy, Args&&...args)
+{
+    return detail::invoke_forall_slots<padded_results>(
+        policy, std::forward<Args>(args)...);
+}
+
+namespace detail
+{
+
+/**
+ * Two-pass parallel scan of `invoke_forall_scan(policy, op, args...)`,
+ * starting from `init` unless it is `no_scan_initial`.
+ */
+template <typename Policy, typename Op, typename Init, typename... Args>
+auto invoke_forall_scan_parallel(Policy& policy, Op& op, Init& init,
+                                 Args&&...args)
+{
+    constexpr std::size_t arity = invoke_count<Args...>;
+    constexpr bool has_initial = !std::is_same_v<Init, no_scan_initial>;
+
+    using value_type = scan_initial_value_t<Init, concurrent_arg_t<Args>...>;
+    using args_type = std::tuple<Args&&...>;
+
+    static constexpr auto invoke_at =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<value_type (*)(args_type&), arity>{
+                [](args_type& refs) -> value_type {
+                    return invoke_stored<arity, Is>(refs);
+                }...
+            };
+        }(std::make_index_sequence<arity>{});
+
+    scan_result<value_type, arity> result{};
+    args_type refs(std::forward<Args>(args)...);
+
+    std::size_t threads = policy_threads(policy);
+    std::size_t grain = (arity + threads - 1) / threads;
+    std::size_t chunks = (arity + grain - 1) / grain;
+
+    for_each_chunk(policy, arity, grain,
+                   [&](std::size_t begin, std::size_t end) {
+        value_type total = invoke_at[begin](refs);
+        result.inclusive[begin] = total;
+        for (std::size_t i = begin + 1; i < end; ++i) {
+            total = std::invoke(op, std::move(total), invoke_at[i](refs));
+            result.inclusive[i] = total;
+        }
+    });
+
+    /*
+     * offsets[c] combines the initial value and the results of all chunks
+     * before chunk `c`.
+     */
+    std::vector<value_type> offsets(chunks);
+    if constexpr (has_initial) {
+        offsets[0] = std::move(init.value);
+    }
+    for (std::size_t c = 1; c < chunks; ++c) {
+        const value_type& last = result.inclusive[c * grain - 1];
+        offsets[c] = c == 1 && !has_initial
+                         ? last
+                         : std::invoke(op, offsets[c - 1], last);
+    }
+
+    for_each_chunk(policy, arity, grain,
+                   [&](std::size_t begin, std::size_t end) {
+        if (begin == 0 && !has_initial) {
+            for (std::size_t i = 1; i < end; ++i) {
+                result.exclusive[i] = result.inclusive[i - 1];
+            }
+            return;
+        }
+
+        const value_type& offset = offsets[begin / grain];
+        value_type previous = offset;
+        for (std::size_t i = begin; i < end; ++i) {
+            result.exclusive[i] = std::move(previous);
+            result.inclusive[i] =
+                std::invoke(op, offset, std::move(result.inclusive[i]));
+            previous = result.inclusive[i];
+        }
+    });
+
+    return result;
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall_scan(op, args...)`, but the invokes are run
+ * according to `policy` as a two-pass scan: the invokes are split into one
+ * chunk of consecutive indices per thread and every chunk is scanned on its
+ * own, then the chunk totals are scanned on the calling thread and combined
+ * with the results of the chunks in a second parallel pass. `op` has to be
+ * associative.
+ */
+template <typename Policy, typename Op, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...>
+auto invoke_forall_scan(Policy&& policy, Op&& op, Args&&...args)
+{
+    detail::no_scan_initial init;
+    return detail::invoke_forall_scan_parallel(policy, op, init,
+                                               std::forward<Args>(args)...);
+}
+
+/**
+ * Same as `invoke_forall_scan(policy, op, args...)`, but both scans start
+ * from `init`, see `invoke_forall_scan(op, init, args...)`.
+ */
+template <typename Policy, typename Op, typename T, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...>
+auto invoke_forall_scan(Policy&& policy, Op&& op,
+                        detail::scan_initial<T> init, Args&&...args)
+{
+    return detail::invoke_forall_scan_parallel(policy, op, init,
+                                               std::forward<Args>(args)...);
+}
+
+/** How an `invoke_forall` call with the `adaptive` policy was run. */
+enum class execution_mode {
+    /* On the calling thread, through the unrolled `invoke_forall`. */
+    sequential,
+    /* As tasks of the thread pool. */
+    pooled,
+    /* On the calling thread, through the kernels of `invoke_forall_simd`. */
+    vectorized,
+};
+
+/**
+ * Statistics of `invoke_forall(adaptive_policy, ...)` calls: an
+ * exponentially weighted moving average of the time of a single invoke
+ * and counters of the chosen execution modes. Thread-safe.
+ */
+class adaptive_stats {
+public:
+    /** Average time of a single invoke in nanoseconds, `-1` if unknown. */
+    double invoke_ns() const { return ewma.load(std::memory_order_relaxed); }
+
+    std::size_t sequential_runs() const { return sequential.load(); }
+    std::size_t pooled_runs() const { return pooled.load(); }
+    std::size_t vectorized_runs() const { return vectorized.load(); }
+
+    /** Invokes per task chosen by the last pooled run. */
+    std::size_t last_grain() const { return grain.load(); }
+
+    /** Makes every following call run in `mode`. */
+    void pin(execution_mode mode) { pinned_mode.store(static_cast<int>(mode)); }
+
+    /** Lets the statistics choose the mode again. */
+    void unpin() { pinned_mode.store(-1); }
+
+    std::optional<execution_mode> pinned() const
+    {
+        int mode = pinned_mode.load();
+        if (mode < 0) {
+            return std::nullopt;
+        }
+        return static_cast<execution_mode>(mode);
+    }
+
+    /** Adds a measured time of a single invoke to the average. */
+    void record(double ns, double alpha)
+    {
+        double old = ewma.load(std::memory_order_relaxed);
+        double next;
+        do {
+            next = old < 0 ? ns : alpha * ns + (1 - alpha) * old;
+        } while (!ewma.compare_exchange_weak(old, next,
+                                             std::memory_order_relaxed));
+    }
+
+    void count(execution_mode mode, std::size_t invokes_per_task)
+    {
+        if (mode == execution_mode::sequential) {
+            ++sequential;
+        } else if (mode == execution_mode::vectorized) {
+            ++vectorized;
+        } else {
+            ++pooled;
+            grain.store(invokes_per_task);
+        }
+    }
+
+private:
+    std::atomic<double> ewma = -1.0;
+    std::atomic<std::size_t> sequential = 0;
+    std::atomic<std::size_t> pooled = 0;
+    std::atomic<std::size_t> vectorized = 0;
+    std::atomic<std::size_t> grain = 0;
+    std::atomic<int> pinned_mode = -1;
+};
+
+/**
+ * Chooses between the calling thread and the pool from the measured cost
+ * of the invokes. The first call with given statistics always runs on the
+ * calling thread, vectorized if the arguments allow it.
+ *
+ * Without `stats`, the statistics are kept per combination of argument
+ * types and per `site`, the place where the policy object was created. An
+ * `adaptive_policy{}` written at a call site therefore keeps its own
+ * statistics, while all calls through the shared `adaptive` constant with
+ * the same argument types share them. Looking them up takes a lock; pass
+ * `stats` to avoid it.
+ */
+struct adaptive_policy {
+    using is_execution_policy_tag = void;
+
+    adaptive_stats *stats = nullptr;
+    thread_pool *pool = nullptr;
+    /* Weight of a new measurement in the moving average. */
+    double alpha = 0.25;
+    /* Estimated sequential time of a call from which on the pool is used. */
+    std::chrono::nanoseconds pool_threshold = std::chrono::microseconds(50);
+    /* Estimated work of a single pooled task. */
+    std::chrono::nanoseconds task_target = std::chrono::microseconds(20);
+    /* Where the policy object was created. */
+    std::source_location site = std::source_location::current();
+
+    /** Used by `invoke_forall_async()`, which always runs on the pool. */
+    template <typename F>
+    void execute(F&& task) const
+    {
+        (pool ? *pool : thread_pool::default_pool())
+            .submit(std::forward<F>(task));
+    }
+};
+
+inline constexpr adaptive_policy adaptive{};
+
+namespace detail
+{
+
+/** Statistics of the `adaptive_policy` objects created at each place. */
+class adaptive_sites {
+public:
+    adaptive_stats& at(const std::source_location& site)
+    {
+        std::lock_guard lock(mutex);
+        return sites[{ site.file_name(), site.line(), site.column() }];
+    }
+
+private:
+    using key = std::tuple<std::string_view, std::uint_least32_t,
+                           std::uint_least32_t>;
+
+    std::mutex mutex;
+    std::map<key, adaptive_stats> sites;
+};
+
+template <typename... Args>
+inline adaptive_sites adaptive_site_stats;
+
+struct execution_choice {
+    execution_mode mode;
+    std::size_t grain;
+};
+
+/**
+ * Chooses how to run `n` invokes on a pool of `threads` threads. Invokes
+ * that stay on the calling thread are `vectorized` if the arguments allow.
+ */
+inline execution_choice choose_execution(const adaptive_policy& policy,
+                                         const adaptive_stats& stats,
+                                         std::size_t n, std::size_t threads,
+                                         bool vectorizable)
+{
+    double cost = stats.invoke_ns();
+    std::size_t per_thread = (n + threads - 1) / threads;
+
+    std::size_t grain = per_thread;
+    if (cost > 0) {
+        auto target = static_cast<double>(policy.task_target.count());
+        grain = std::clamp<std::size_t>(
+            static_cast<std::size_t>(target / cost) + 1, 1, per_thread);
+    }
+
+    execution_mode local = vectorizable ? execution_mode::vectorized
+                                        : execution_mode::sequential;
+
+    if (auto mode = stats.pinned()) {
+        if (*mode == execution_mode::vectorized) {
+            return { local, n };
+        }
+        return { *mode, grain };
+    }
+
+    if (cost < 0 || threads < 2 || n < 2 ||
+        cost * static_cast<double>(n) <
+            static_cast<double>(policy.pool_threshold.count())) {
+        return { local, n };
+    }
+    return { execution_mode::pooled, grain };
+}
+
+/**
+ * Records the time of a call on the calling thread as the time of a single
+ * invoke on exit.
+ */
+struct invoke_timer {
+    adaptive_stats& stats;
+    double alpha;
+    /* Number of invokes done one after another by a single thread. */
+    double serial_invokes;
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+
+    ~invoke_timer()
+    {
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        stats.record(elapsed.count() / serial_invokes, alpha);
+    }
+};
+
+/**
+ * Sums up the time the pool's workers spend in the tasks of a pooled call
+ * and records it, divided by the number of invokes, as the time of a
+ * single invoke on exit, after all tasks have reported. Dispatching the
+ * tasks and waiting for them is not measured, so the estimate stays
+ * comparable to the one of sequential calls.
+ */
+struct pooled_work_timer {
+    adaptive_stats& stats;
+    double alpha;
+    std::size_t invokes;
+    std::latch tasks_done;
+    std::atomic<std::int64_t> work_ns = 0;
+
+    pooled_work_timer(adaptive_stats& stats, double alpha, std::size_t invokes,
+                      std::size_t tasks)
+        : stats(stats), alpha(alpha), invokes(invokes),
+          tasks_done(static_cast<std::ptrdiff_t>(tasks))
+    {
+    }
+
+    ~pooled_work_timer()
+    {
+        tasks_done.wait();
+        stats.record(static_cast<double>(work_ns.load()) /
+                         static_cast<double>(invokes),
+                     alpha);
+    }
+};
+
+/** `parallel_policy` whose tasks report their run time to a timer. */
+struct timed_parallel_policy {
+    using is_execution_policy_tag = void;
+
+    thread_pool *pool;
+    std::size_t grain;
+    pooled_work_timer *timer;
+
+    template <typename F>
+    void execute(F&& task) const
+    {
+        pool->submit([task = std::forward<F>(task), timer = timer]() mutable {
+            auto begin = std::chrono::steady_clock::now();
+            task();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin);
+            timer->work_ns.fetch_add(elapsed.count(),
+                                     std::memory_order_relaxed);
+            timer->tasks_done.count_down();
+        });
+    }
+};
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)`, but runs the invokes on the calling
+ * thread, vectorized where `invoke_forall_simd` can, or on the thread pool,
+ * depending on the statistics of the argument types and the policy's site,
+ * or on `policy.stats`.
+ */
+template <typename Policy, typename... Args>
+requires detail::ExecutionPolicy<Policy> && detail::NonEmpty<Args...> &&
+         detail::SameArity<Args...> &&
+         std::same_as<std::remove_cvref_t<Policy>, adaptive_policy>
+decltype(auto) invoke_forall(Policy&& policy, Args&&...args)
+{
+    if constexpr (detail::NoneGettable<Args...>) {
+        return invoke_forall(std::forward<Args>(args)...);
+    } else {
+        constexpr std::size_t n = detail::invoke_count<Args...>;
+        constexpr bool vectorizable = detail::SimdKernel<Args...>;
+
+        adaptive_stats& stats =
+            policy.stats
+                ? *policy.stats
+                : detail::adaptive_site_stats<Args...>.at(policy.site);
+        thread_pool& pool =
+            policy.pool ? *policy.pool : thread_pool::default_pool();
+
+        auto [mode, grain] = detail::choose_execution(
+            policy, stats, n, pool.size(), vectorizable);
+        stats.count(mode, grain);
+
+        if constexpr (vectorizable) {
+            if (mode == execution_mode::vectorized) {
+                detail::invoke_timer timer{ stats, policy.alpha, double(n) };
+                return detail::invoke_simd_dispatched(args...);
+            }
+        }
+        if (mode == execution_mode::sequential) {
+            detail::invoke_timer timer{ stats, policy.alpha, double(n) };
+            return invoke_forall(std::forward<Args>(args)...);
+        } else {
+            detail::pooled_work_timer timer(stats, policy.alpha, n,
+                                            (n + grain - 1) / grain);
+            return invoke_forall(
+                detail::timed_parallel_policy{ &pool, grain, &timer },
+                std::forward<Args>(args)...);
+        }
+    }
+}
+
+#endif /* INVOKE_FORALL_PARALLEL_H */
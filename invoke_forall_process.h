@@ -0,0 +1,480 @@
+/**
+ * Process-isolated execution of the invokes performed by `invoke_forall`
+ * (Linux only).
+ *
+ * `invoke_forall_expected(isolated, args...)` returns the same results as
+ * `invoke_forall_expected(args...)`, but every invoke runs in one of a pool
+ * of worker processes forked for the call, so callables that rely on global
+ * state can use all cores, and a crash of an invoke does not take down the
+ * caller. Workers take indices from a work counter in an anonymous shared
+ * memory region and write the results into per-index slots of the same
+ * region. An invoke whose worker dies (signal, `exit()`) before writing its
+ * result yields a `process_invoke_error` for its index that tells the
+ * signal or the exit status, and a new worker is forked for the remaining
+ * indices.
+ *
+ * Workers are forked from the calling thread and see a copy-on-write
+ * snapshot of the caller, arguments included; nothing written by an invoke
+ * is visible to the caller except its result. Results have to be trivially
+ * copyable. In multi-threaded programs the callables must not depend on
+ * locks held by other threads at the time of the call. Workers are killed
+ * when the caller dies.
+ */
+
+#ifndef INVOKE_FORALL_PROCESS_H
+#define INVOKE_FORALL_PROCESS_H
+
+#include "invoke_forall.h"
+#include "invoke_forall_expected.h"
+#include "invoke_forall_parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <expected>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** Selects process-isolated execution, see the top of this file. */
+struct process_policy {
+    /* Number of worker processes, `0` means one per core. */
+    std::size_t workers = 0;
+};
+
+inline constexpr process_policy isolated{};
+
+/**
+ * Error of an invoke that threw, whose worker process died before writing
+ * its result, or that was taken by a worker that died before starting it.
+ */
+class process_invoke_error : public std::runtime_error {
+public:
+    process_invoke_error(const std::string& what, bool crashed, int signal,
+                         int exit_status = -1)
+        : std::runtime_error(what), worker_crashed(crashed),
+          signal_number(signal), status(exit_status)
+    {
+    }
+
+    /** True if the worker died, false if the invoke threw. */
+    bool crashed() const noexcept { return worker_crashed; }
+
+    /** Signal that killed the worker, `0` if there was none. */
+    int signal() const noexcept { return signal_number; }
+
+    /**
+     * Status the worker passed to `exit()` or `_exit()` during the invoke,
+     * `-1` if it did not exit that way.
+     */
+    int exit_status() const noexcept { return status; }
+
+private:
+    bool worker_crashed;
+    int signal_number;
+    int status;
+};
+
+namespace detail
+{
+
+enum class process_slot_state : unsigned char {
+    pending,
+    running,
+    done,
+    failed,
+    crashed,
+};
+
+/** Progress of a single invoke, shared between the caller and workers. */
+struct alignas(cache_line_size) process_slot {
+    std::atomic<process_slot_state> state{ process_slot_state::pending };
+    /* Worker running the invoke, valid once the state is not pending. */
+    int worker = -1;
+    /* Signal that killed the worker, if any. */
+    int code = 0;
+    /* Status of a worker that exited during the invoke, if any. */
+    int exit_status = -1;
+    char message[192] = {};
+};
+
+/** Uninitialized storage for a result written by a worker. */
+template <typename R>
+struct alignas(R) process_value {
+    unsigned char bytes[sizeof(R)];
+
+    R *get() noexcept { return std::launder(reinterpret_cast<R *>(bytes)); }
+};
+
+/** Layout of the shared memory region of a call with results `Rs`. */
+template <typename... Rs>
+struct process_shared {
+    static constexpr std::size_t size = sizeof...(Rs);
+
+    /* Index of the next invoke to be taken by a worker. */
+    alignas(cache_line_size) std::atomic<std::size_t> next = 0;
+    std::array<process_slot, size> slots;
+    std::tuple<process_value<Rs>...> values;
+};
+
+/** An anonymous shared mapping holding a `T`, unmapped on destruction. */
+template <typename T>
+class shared_region {
+public:
+    shared_region()
+    {
+        void *data = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category(), "mmap");
+        }
+        object = new (data) T();
+    }
+
+    shared_region(const shared_region&) = delete;
+    shared_region& operator=(const shared_region&) = delete;
+
+    ~shared_region()
+    {
+        object->~T();
+        munmap(object, sizeof(T));
+    }
+
+    T& operator*() const noexcept { return *object; }
+
+private:
+    T *object;
+};
+
+template <typename R>
+using process_result_t = std::remove_cv_t<R>;
+
+template <std::size_t A, typename Is, typename... Args>
+struct process_shared_for;
+
+template <std::size_t A, std::size_t... Is, typename... Args>
+struct process_shared_for<A, std::index_sequence<Is...>, Args...> {
+    using type = process_shared<process_result_t<
+        invoke_at_result_t<A, Is, concurrent_arg_t<Args>...>>...>;
+};
+
+template <typename... Args>
+using process_shared_t = typename process_shared_for<
+    invoke_count<Args...>, std::make_index_sequence<invoke_count<Args...>>,
+    Args...>::type;
+
+/** Copies `what` into the message of `slot`, truncating it if needed. */
+inline void set_slot_message(process_slot& slot, const char *what) noexcept
+{
+    std::strncpy(slot.message, what, sizeof(slot.message) - 1);
+}
+
+/**
+ * Performs the `I`-th invoke in a worker and publishes its result or the
+ * message of the exception it threw in the `I`-th slot.
+ */
+template <std::size_t I, typename Shared, typename... Args>
+void run_in_worker(Shared& shared, std::tuple<Args...>& args) noexcept
+{
+    using value_type =
+        std::remove_pointer_t<decltype(std::get<I>(shared.values).get())>;
+
+    process_slot& slot = shared.slots[I];
+    auto state = process_slot_state::done;
+
+    try {
+        ::new (std::get<I>(shared.values).bytes)
+            value_type(invoke_stored<Shared::size, I>(args));
+    } catch (const std::exception& e) {
+        set_slot_message(slot, e.what());
+        state = process_slot_state::failed;
+    } catch (...) {
+        set_slot_message(slot, "unknown exception");
+        state = process_slot_state::failed;
+    }
+
+    slot.state.store(state, std::memory_order_release);
+}
+
+/** Body of worker `w`: takes indices until all invokes have been taken. */
+template <typename Shared, typename... Args>
+[[noreturn]] void worker_main(Shared& shared, int w,
+                              std::tuple<Args...>& args) noexcept
+{
+    static constexpr auto run_at =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<void (*)(Shared&, std::tuple<Args...>&),
+                              Shared::size>{ &run_in_worker<Is>... };
+        }(std::make_index_sequence<Shared::size>{});
+
+    while (true) {
+        std::size_t i = shared.next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= Shared::size) {
+            break;
+        }
+
+        shared.slots[i].worker = w;
+        shared.slots[i].state.store(process_slot_state::running,
+                                    std::memory_order_release);
+        run_at[i](shared, args);
+    }
+
+    _exit(0);
+}
+
+/** A forked worker and the read end of a pipe that closes when it dies. */
+struct worker_process {
+    pid_t pid = -1;
+    int fd = -1;
+};
+
+/**
+ * Forks worker `w`. The child holds the only write end of a pipe, so the
+ * caller can wait for any of its workers with `poll()` without reaping
+ * unrelated children.
+ */
+template <typename Shared, typename... Args>
+worker_process fork_worker(Shared& shared, int w, std::tuple<Args...>& args,
+                           const std::vector<worker_process>& workers)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::system_error(errno, std::system_category(), "pipe2");
+    }
+
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid < 0) {
+        int error = errno;
+        close(fds[0]);
+        close(fds[1]);
+        throw std::system_error(error, std::system_category(), "fork");
+    }
+
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) {
+            _exit(1);
+        }
+
+        close(fds[0]);
+        for (const auto& other : workers) {
+            if (other.fd >= 0) {
+                close(other.fd);
+            }
+        }
+        worker_main(shared, w, args);
+    }
+
+    close(fds[1]);
+    return { pid, fds[0] };
+}
+
+/**
+ * Marks the invoke that worker `w` was running when it died or exited as
+ * crashed. A worker that finished all its invokes has none left running.
+ */
+template <typename Shared>
+void mark_crashed(Shared& shared, int w, int status)
+{
+    for (auto& slot : shared.slots) {
+        if (slot.state.load(std::memory_order_acquire) ==
+                process_slot_state::running &&
+            slot.worker == w) {
+            std::string what;
+            if (WIFSIGNALED(status)) {
+                slot.code = WTERMSIG(status);
+                what = "worker killed by signal " + std::to_string(slot.code);
+            } else {
+                slot.exit_status = WEXITSTATUS(status);
+                what = "worker exited with status " +
+                       std::to_string(slot.exit_status) +
+                       " before writing the result";
+            }
+            set_slot_message(slot, what.c_str());
+            slot.state.store(process_slot_state::crashed,
+                             std::memory_order_release);
+        }
+    }
+}
+
+/**
+ * Forks `count` workers and waits until all invokes have finished, forking
+ * a new worker for every one that dies while invokes remain.
+ */
+template <typename Shared, typename... Args>
+void run_workers(Shared& shared, std::size_t count, std::tuple<Args...>& args)
+{
+    std::vector<worker_process> workers(count);
+
+    /* Output buffered before the fork would be flushed by every worker. */
+    std::fflush(nullptr);
+
+    auto cleanup = [&] {
+        for (auto& worker : workers) {
+            if (worker.pid > 0) {
+                kill(worker.pid, SIGKILL);
+                waitpid(worker.pid, nullptr, 0);
+                close(worker.fd);
+            }
+        }
+    };
+
+    try {
+        for (std::size_t w = 0; w < count; ++w) {
+            workers[w] = fork_worker(shared, static_cast<int>(w), args,
+                                     workers);
+        }
+
+        std::size_t alive = count;
+        std::vector<pollfd> fds(count);
+
+        while (alive > 0) {
+            for (std::size_t w = 0; w < count; ++w) {
+                fds[w] = { workers[w].fd, 0, 0 };
+            }
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category(), "poll");
+            }
+
+            for (std::size_t w = 0; w < count; ++w) {
+                if (workers[w].pid <= 0 || fds[w].revents == 0) {
+                    continue;
+                }
+
+                int status = 0;
+                while (waitpid(workers[w].pid, &status, 0) < 0 &&
+                       errno == EINTR) {
+                }
+                close(workers[w].fd);
+                workers[w] = {};
+                --alive;
+
+                /* An invoke may exit the worker, even with status 0. */
+                mark_crashed(shared, static_cast<int>(w), status);
+                if (shared.next.load() < Shared::size) {
+                    workers[w] = fork_worker(shared, static_cast<int>(w),
+                                             args, workers);
+                    ++alive;
+                }
+            }
+        }
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+}
+
+/** Converts the `I`-th slot into the `I`-th result of the call. */
+template <std::size_t I, typename Shared>
+auto take_process_result(Shared& shared)
+{
+    using value_type =
+        std::remove_pointer_t<decltype(std::get<I>(shared.values).get())>;
+    using result_type = std::expected<value_type, std::exception_ptr>;
+
+    const process_slot& slot = shared.slots[I];
+
+    switch (slot.state.load(std::memory_order_acquire)) {
+    case process_slot_state::done:
+        return result_type(*std::get<I>(shared.values).get());
+    case process_slot_state::failed:
+        return result_type(std::unexpect,
+                           std::make_exception_ptr(process_invoke_error(
+                               slot.message, false, 0)));
+    case process_slot_state::crashed:
+        return result_type(std::unexpect,
+                           std::make_exception_ptr(process_invoke_error(
+                               slot.message, true, slot.code,
+                               slot.exit_status)));
+    default:
+        /* taken by a worker that died before it could start the invoke */
+        return result_type(std::unexpect,
+                           std::make_exception_ptr(process_invoke_error(
+                               "worker died before starting the invoke", true,
+                               0)));
+    }
+}
+
+template <typename Shared, std::size_t... Is>
+auto take_process_results(Shared& shared, std::index_sequence<Is...>)
+{
+    using first_type = decltype(take_process_result<0>(shared));
+
+    if constexpr ((... && std::same_as<first_type,
+                                       decltype(take_process_result<Is>(
+                                           shared))>)) {
+        return std::array<first_type, sizeof...(Is)>{
+            take_process_result<Is>(shared)...
+        };
+    } else {
+        return std::tuple<decltype(take_process_result<Is>(shared))...>{
+            take_process_result<Is>(shared)...
+        };
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall_expected(args...)`, but every invoke runs in a
+ * worker process, see the top of this file. The `i`-th result holds either
+ * the result of the `i`-th invoke or a `process_invoke_error`. Without
+ * Gettable arguments the single invoke yields a single `std::expected`.
+ */
+template <typename Policy, typename... Args>
+requires std::same_as<std::remove_cvref_t<Policy>, process_policy> &&
+         detail::NonEmpty<Args...> && detail::SameArity<Args...>
+auto invoke_forall_expected(Policy&& policy, Args&&...args)
+{
+    using shared_type = detail::process_shared_t<Args...>;
+
+    static_assert(
+        []<typename... Rs>(detail::process_shared<Rs...> *) {
+            return (... && (std::is_trivially_copyable_v<Rs> &&
+                            !std::is_reference_v<Rs>));
+        }(static_cast<shared_type *>(nullptr)),
+        "process-isolated invokes have to return trivially copyable values");
+
+    std::size_t count = policy.workers;
+    if (count == 0) {
+        count = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    count = std::min(count, shared_type::size);
+
+    detail::shared_region<shared_type> region;
+    std::tuple<Args&&...> refs(std::forward<Args>(args)...);
+
+    detail::run_workers(*region, count, refs);
+
+    if constexpr (detail::NoneGettable<Args...>) {
+        return detail::take_process_result<0>(*region);
+    } else {
+        return detail::take_process_results(
+            *region, std::make_index_sequence<shared_type::size>{});
+    }
+}
+
+#endif /* INVOKE_FORALL_PROCESS_H */
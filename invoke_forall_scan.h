@@ -0,0 +1,161 @@
+/**
+ * Prefix scans over the results of `invoke_forall`.
+ *
+ * `invoke_forall_scan` combines the results of the invokes into running
+ * totals (inclusive and exclusive prefix scans) as they are produced,
+ * starting from an initial value passed with `scan_init()`.
+ */
+
+#ifndef INVOKE_FORALL_SCAN_H
+#define INVOKE_FORALL_SCAN_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Result of `invoke_forall_scan()`: `inclusive[i]` combines the initial
+ * value and the results of invokes `0, ..., i`, `exclusive[i]` the initial
+ * value and the results of invokes `0, ..., i - 1`, so `exclusive[0]` is
+ * the initial value. Without an initial value the scans start with the
+ * result of invoke `0` and `exclusive[0]` is value-initialized.
+ */
+INVOKE_FORALL_EXPORT template <typename T, std::size_t N>
+struct scan_result {
+    std::array<T, N> inclusive;
+    std::array<T, N> exclusive;
+};
+
+namespace detail
+{
+
+/** Initial value of a scan, wrapped by `scan_init()`. */
+template <typename T>
+struct scan_initial {
+    T value;
+};
+
+/** Stands for a missing initial value. */
+struct no_scan_initial {};
+
+/** Type of the running totals of `invoke_forall_scan(op, args...)`. */
+template <typename Is, typename... Args>
+struct scan_value;
+
+template <std::size_t... Is, typename... Args>
+struct scan_value<std::index_sequence<Is...>, Args...> {
+    using type = std::common_type_t<std::remove_cvref_t<
+        invoke_at_result_t<sizeof...(Is), Is, Args...>>...>;
+};
+
+template <typename... Args>
+using scan_value_t =
+    typename scan_value<std::make_index_sequence<invoke_count<Args...>>,
+                        Args...>::type;
+
+/** Type of the running totals when the scan starts from `Init`. */
+template <typename Init, typename... Args>
+struct scan_initial_value {
+    using type = scan_value_t<Args...>;
+};
+
+template <typename T, typename... Args>
+struct scan_initial_value<scan_initial<T>, Args...> {
+    using type = std::common_type_t<scan_value_t<Args...>, T>;
+};
+
+template <typename Init, typename... Args>
+using scan_initial_value_t = typename scan_initial_value<Init, Args...>::type;
+
+/**
+ * Performs the invokes in order and folds every result into the running
+ * total right away, writing both scans directly into the result.
+ */
+template <typename Op, typename Init, std::size_t... Is, typename... Args>
+constexpr auto invoke_for_all_indices_scan(Op& op, Init& init,
+                                           std::index_sequence<Is...>,
+                                           Args&&...args)
+{
+    constexpr size_t arity = sizeof...(Is);
+    constexpr bool has_initial = !std::is_same_v<Init, no_scan_initial>;
+
+    using value_type = scan_initial_value_t<Init, Args...>;
+
+    scan_result<value_type, arity> result{};
+    value_type total{};
+    if constexpr (has_initial) {
+        total = std::move(init.value);
+    }
+    no_hooks hooks;
+
+    auto step = [&]<std::size_t I>() {
+        value_type current(
+            invoke_at_wrapper<arity, I>(hooks, std::forward<Args>(args)...));
+
+        result.exclusive[I] = total;
+        if constexpr (I == 0 && !has_initial) {
+            total = std::move(current);
+        } else {
+            total = std::invoke(op, std::move(total), std::move(current));
+        }
+        result.inclusive[I] = total;
+    };
+    (step.template operator()<Is>(), ...);
+
+    return result;
+}
+
+template <typename Op, typename Init, typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...>
+constexpr auto invoke_forall_scan(Op&& op, Init init, Args&&...args)
+{
+    return invoke_for_all_indices_scan(
+        op, init, std::make_index_sequence<invoke_count<Args...>>{},
+        std::forward<Args>(args)...);
+}
+
+} /* namespace detail */
+
+/**
+ * Wraps the initial value of a scan, passed to `invoke_forall_scan()`
+ * right after the operation.
+ */
+INVOKE_FORALL_EXPORT template <typename T>
+constexpr auto scan_init(T&& value)
+{
+    return detail::scan_initial<std::decay_t<T>>{ std::forward<T>(value) };
+}
+
+/**
+ * Performs the same invokes as `invoke_forall(args...)` and returns the
+ * inclusive and exclusive prefix scans of their results under the binary
+ * operation `op`, see `scan_result`. Results of different types are
+ * combined in their common type.
+ */
+INVOKE_FORALL_EXPORT template <typename Op, typename... Args>
+constexpr auto invoke_forall_scan(Op&& op, Args&&...args)
+{
+    return detail::invoke_forall_scan(std::forward<Op>(op),
+                                      detail::no_scan_initial{},
+                                      std::forward<Args>(args)...);
+}
+
+/**
+ * Same as `invoke_forall_scan(op, args...)`, but both scans start from
+ * `init`: `exclusive[0]` is `init` and `inclusive[i]` folds the results
+ * into `init`. Needed whenever a value-initialized total is not the
+ * identity of `op`, e.g. for products or maxima of negative numbers.
+ */
+INVOKE_FORALL_EXPORT template <typename Op, typename T, typename... Args>
+constexpr auto invoke_forall_scan(Op&& op, detail::scan_initial<T> init,
+                                  Args&&...args)
+{
+    return detail::invoke_forall_scan(std::forward<Op>(op), std::move(init),
+                                      std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_SCAN_H */
@@ -0,0 +1,452 @@
+/**
+ * Sender adaptor for `invoke_forall` in the style of P2300 `std::execution`.
+ *
+ * `invoke_forall_sender(sched, args...)` returns a lazy sender that, once
+ * connected and started, schedules every invoke of `invoke_forall(args...)`
+ * as its own operation on the scheduler `sched`, like `bulk`, and completes
+ * with the same `std::array` or `std::tuple` of results that
+ * `invoke_forall(args...)` returns. If an invoke throws, it completes with
+ * the `std::exception_ptr` of the failed invoke with the lowest index; if
+ * the scheduler fails or stops, so does the sender. Arguments are copied or
+ * moved into the sender, use `std::ref` to pass references.
+ *
+ * The senders, receivers and schedulers of this file follow the member
+ * function protocol of P2300R10 (`schedule()`, `connect()`, `start()`,
+ * `set_value()`, `set_error()`, `set_stopped()`). If `std::execution` is
+ * available, or `INVOKE_FORALL_EXECUTION` names the namespace of another
+ * implementation (such as `stdexec`), they also declare the concept tags
+ * and completion signatures of that namespace and go through its customization
+ * points, so they compose with its `then`, `when_all`, `let_value` and
+ * schedulers.
+ *
+ * `inline_scheduler` runs its operations on the thread that starts them,
+ * `pool_scheduler` as tasks of a `thread_pool`.
+ */
+
+#ifndef INVOKE_FORALL_SENDER_H
+#define INVOKE_FORALL_SENDER_H
+
+#include "invoke_forall.h"
+#include "invoke_forall_parallel.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if !defined(INVOKE_FORALL_EXECUTION) && defined(__cpp_lib_senders)
+#include <execution>
+#define INVOKE_FORALL_EXECUTION std::execution
+#endif
+
+namespace detail
+{
+
+/*
+ * The protocol calls, through the customization points of
+ * `INVOKE_FORALL_EXECUTION` if given, through the members otherwise.
+ */
+#ifdef INVOKE_FORALL_EXECUTION
+namespace exec = INVOKE_FORALL_EXECUTION;
+
+template <typename Scheduler>
+decltype(auto) exec_schedule(Scheduler& sched)
+{
+    return exec::schedule(sched);
+}
+
+template <typename Sender, typename Receiver>
+decltype(auto) exec_connect(Sender&& sender, Receiver&& receiver)
+{
+    return exec::connect(std::forward<Sender>(sender),
+                         std::forward<Receiver>(receiver));
+}
+
+template <typename Op>
+void exec_start(Op& op) noexcept
+{
+    exec::start(op);
+}
+
+template <typename Receiver, typename... Vs>
+void exec_set_value(Receiver&& receiver, Vs&&...vs) noexcept
+{
+    exec::set_value(std::move(receiver), std::forward<Vs>(vs)...);
+}
+
+template <typename Receiver>
+void exec_set_error(Receiver&& receiver, std::exception_ptr error) noexcept
+{
+    exec::set_error(std::move(receiver), std::move(error));
+}
+
+template <typename Receiver>
+void exec_set_stopped(Receiver&& receiver) noexcept
+{
+    exec::set_stopped(std::move(receiver));
+}
+
+/** Concept tags and completion signatures of a sender of `Vs...`. */
+template <typename... Vs>
+struct sender_base {
+    using sender_concept = exec::sender_t;
+    using completion_signatures =
+        exec::completion_signatures<exec::set_value_t(Vs...),
+                                    exec::set_error_t(std::exception_ptr),
+                                    exec::set_stopped_t()>;
+};
+
+struct receiver_base {
+    using receiver_concept = exec::receiver_t;
+};
+
+struct operation_base {
+    using operation_state_concept = exec::operation_state_t;
+};
+#else
+template <typename Scheduler>
+decltype(auto) exec_schedule(Scheduler& sched)
+{
+    return sched.schedule();
+}
+
+template <typename Sender, typename Receiver>
+decltype(auto) exec_connect(Sender&& sender, Receiver&& receiver)
+{
+    return std::forward<Sender>(sender).connect(
+        std::forward<Receiver>(receiver));
+}
+
+template <typename Op>
+void exec_start(Op& op) noexcept
+{
+    op.start();
+}
+
+template <typename Receiver, typename... Vs>
+void exec_set_value(Receiver&& receiver, Vs&&...vs) noexcept
+{
+    std::move(receiver).set_value(std::forward<Vs>(vs)...);
+}
+
+template <typename Receiver>
+void exec_set_error(Receiver&& receiver, std::exception_ptr error) noexcept
+{
+    std::move(receiver).set_error(std::move(error));
+}
+
+template <typename Receiver>
+void exec_set_stopped(Receiver&& receiver) noexcept
+{
+    std::move(receiver).set_stopped();
+}
+
+template <typename... Vs>
+struct sender_base {};
+
+struct receiver_base {};
+
+struct operation_base {};
+#endif
+
+/** Converts an error of any type into an `std::exception_ptr`. */
+template <typename E>
+std::exception_ptr as_exception_ptr(E&& error) noexcept
+{
+    if constexpr (std::same_as<std::remove_cvref_t<E>, std::exception_ptr>) {
+        return std::forward<E>(error);
+    } else {
+        return std::make_exception_ptr(std::forward<E>(error));
+    }
+}
+
+/**
+ * Converts to the result of `f()`, so that `std::optional::emplace()` can
+ * construct immovable operation states in place.
+ */
+template <typename F>
+struct emplace_from {
+    F f;
+
+    operator decltype(std::declval<F&>()())() { return f(); }
+};
+
+} /* namespace detail */
+
+/** Scheduler whose operations complete on the thread that starts them. */
+struct inline_scheduler {
+    struct sender : detail::sender_base<> {
+        template <typename Receiver>
+        struct operation : detail::operation_base {
+            Receiver receiver;
+
+            void start() & noexcept
+            {
+                detail::exec_set_value(std::move(receiver));
+            }
+        };
+
+        template <typename Receiver>
+        operation<std::remove_cvref_t<Receiver>>
+        connect(Receiver&& receiver) const
+        {
+            return { {}, std::forward<Receiver>(receiver) };
+        }
+    };
+
+    sender schedule() const noexcept { return {}; }
+
+    bool operator==(const inline_scheduler&) const = default;
+};
+
+/** Scheduler whose operations complete as tasks of `pool`. */
+class pool_scheduler {
+public:
+    explicit pool_scheduler(thread_pool& pool = thread_pool::default_pool())
+        : target(&pool)
+    {
+    }
+
+    struct sender : detail::sender_base<> {
+        template <typename Receiver>
+        struct operation : detail::operation_base {
+            thread_pool *pool;
+            Receiver receiver;
+
+            void start() & noexcept
+            {
+                try {
+                    pool->submit([this] {
+                        detail::exec_set_value(std::move(receiver));
+                    });
+                } catch (...) {
+                    detail::exec_set_error(std::move(receiver),
+                                           std::current_exception());
+                }
+            }
+        };
+
+        template <typename Receiver>
+        operation<std::remove_cvref_t<Receiver>>
+        connect(Receiver&& receiver) const
+        {
+            return { {}, pool, std::forward<Receiver>(receiver) };
+        }
+
+        thread_pool *pool;
+    };
+
+    sender schedule() const noexcept { return { {}, target }; }
+
+    bool operator==(const pool_scheduler&) const = default;
+
+private:
+    thread_pool *target;
+};
+
+namespace detail
+{
+
+template <typename... Args>
+using forall_stream_t = async_stream_t<Args...>;
+
+/** Value the sender of `invoke_forall(args...)` completes with. */
+template <typename... Args>
+using forall_value_t = decltype(take_all(
+    std::declval<forall_stream_t<Args...>&>(),
+    std::make_index_sequence<forall_stream_t<Args...>::size>{}));
+
+/**
+ * Operation state of `invoke_forall_sender()`: the arguments and results,
+ * together with one scheduled operation per invoke.
+ */
+template <typename Scheduler, typename Receiver, typename... Args>
+class forall_operation : public operation_base,
+                         async_state<forall_stream_t<Args...>, Args...> {
+    using stream_type = forall_stream_t<Args...>;
+    using state_type = async_state<stream_type, Args...>;
+
+    static constexpr std::size_t arity = stream_type::size;
+
+    /** Receives the completion of the scheduled operation of one invoke. */
+    struct index_receiver : receiver_base {
+        forall_operation *op;
+        std::size_t index;
+
+        void set_value() && noexcept
+        {
+            produce_at[index](*op);
+            op->finish_one();
+        }
+
+        template <typename E>
+        void set_error(E&& error) && noexcept
+        {
+            op->fail(as_exception_ptr(std::forward<E>(error)));
+            op->finish_one();
+        }
+
+        void set_stopped() && noexcept
+        {
+            op->stopped.store(true, std::memory_order_relaxed);
+            op->finish_one();
+        }
+    };
+
+    using inner_operation = decltype(exec_connect(
+        exec_schedule(std::declval<Scheduler&>()), index_receiver{}));
+
+    static constexpr auto produce_at =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<void (*)(state_type&), arity>{
+                [](state_type& st) {
+                    st.template produce<Is>([&]() -> decltype(auto) {
+                        return invoke_stored<arity, Is>(st.args);
+                    });
+                }...
+            };
+        }(std::make_index_sequence<arity>{});
+
+public:
+    template <typename... Ts>
+    forall_operation(Scheduler sched, Receiver receiver, Ts&&...ts)
+        : state_type(std::forward<Ts>(ts)...), scheduler(std::move(sched)),
+          receiver(std::move(receiver))
+    {
+    }
+
+    forall_operation(const forall_operation&) = delete;
+    forall_operation& operator=(const forall_operation&) = delete;
+
+    void start() & noexcept
+    {
+        try {
+            for (std::size_t i = 0; i < arity; ++i) {
+                operations[i].emplace(emplace_from{ [this, i] {
+                    return exec_connect(exec_schedule(scheduler),
+                                        index_receiver{ {}, this, i });
+                } });
+            }
+        } catch (...) {
+            exec_set_error(std::move(receiver), std::current_exception());
+            return;
+        }
+
+        /* The last start can complete and destroy this operation. */
+        for (std::size_t i = 0; i < arity; ++i) {
+            exec_start(*operations[i]);
+        }
+    }
+
+private:
+    void fail(std::exception_ptr error) noexcept
+    {
+        bool expected = false;
+        if (failed.compare_exchange_strong(expected, true)) {
+            schedule_error = std::move(error);
+        }
+    }
+
+    /** Completes the receiver once every scheduled operation completed. */
+    void finish_one() noexcept
+    {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        if (failed.load(std::memory_order_relaxed)) {
+            exec_set_error(std::move(receiver), std::move(schedule_error));
+            return;
+        }
+        if (stopped.load(std::memory_order_relaxed)) {
+            exec_set_stopped(std::move(receiver));
+            return;
+        }
+
+        std::optional<forall_value_t<Args...>> value;
+        try {
+            this->rethrow_first_error();
+            value.emplace(emplace_from{ [this] {
+                return take_all(static_cast<stream_type&>(*this),
+                                std::make_index_sequence<arity>{});
+            } });
+        } catch (...) {
+            exec_set_error(std::move(receiver), std::current_exception());
+            return;
+        }
+        exec_set_value(std::move(receiver), std::move(*value));
+    }
+
+    Scheduler scheduler;
+    Receiver receiver;
+    std::array<std::optional<inner_operation>, arity> operations;
+    std::atomic<std::size_t> remaining = arity;
+    std::atomic<bool> failed = false;
+    std::atomic<bool> stopped = false;
+    std::exception_ptr schedule_error;
+};
+
+/** Sender returned by `invoke_forall_sender()`. */
+template <typename Scheduler, typename... Args>
+class forall_sender : public sender_base<forall_value_t<Args...>> {
+    template <typename Receiver>
+    using operation_type =
+        forall_operation<Scheduler, std::remove_cvref_t<Receiver>, Args...>;
+
+public:
+    template <typename... Ts>
+    explicit forall_sender(Scheduler sched, Ts&&...ts)
+        : scheduler(std::move(sched)), args(std::forward<Ts>(ts)...)
+    {
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver&& receiver) &&
+    {
+        return std::apply(
+            [&](Args&...stored) {
+                return operation_type<Receiver>(
+                    std::move(scheduler), std::forward<Receiver>(receiver),
+                    std::forward<Args>(stored)...);
+            },
+            args);
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver&& receiver) const&
+    {
+        return std::apply(
+            [&](const Args&...stored) {
+                return operation_type<Receiver>(
+                    scheduler, std::forward<Receiver>(receiver), stored...);
+            },
+            args);
+    }
+
+private:
+    Scheduler scheduler;
+    std::tuple<Args...> args;
+};
+
+} /* namespace detail */
+
+/**
+ * Returns a sender of the results of `invoke_forall(args...)`, whose
+ * invokes run on `sched`, see the top of this file.
+ */
+template <typename Scheduler, typename... Args>
+requires detail::NonEmpty<Args...> &&
+         detail::SameArity<std::unwrap_ref_decay_t<Args>...> &&
+         (!detail::NoneGettable<std::unwrap_ref_decay_t<Args>...>)
+auto invoke_forall_sender(Scheduler sched, Args&&...args)
+{
+    return detail::forall_sender<Scheduler, std::unwrap_ref_decay_t<Args>...>(
+        std::move(sched), std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_SENDER_H */
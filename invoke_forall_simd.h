@@ -0,0 +1,254 @@
+/**
+ * `invoke_forall` over arrays of arithmetic values, compiled for several
+ * instruction sets and dispatched at run time.
+ *
+ * `invoke_forall_simd(args...)` returns the same result as
+ * `invoke_forall(args...)`. If every Gettable argument is an `std::array` of
+ * arithmetic values, no other argument is Gettable and the invokes return
+ * an arithmetic type, the invokes are performed by a plain loop that the
+ * compiler can vectorize. The loop is instantiated once for every variant
+ * in `simd_isa`, each compiled for its instruction set (on x86-64 with GCC
+ * or Clang), so a binary built without `-march` still uses the full vector
+ * width of the CPU it runs on. The best variant supported by the CPU is
+ * detected once at startup, and every kernel caches the pointer to its
+ * variant on first use. All other calls are forwarded to `invoke_forall`.
+ *
+ * `invoke_forall_simd(isa, args...)` runs the given variant, which lets
+ * tests compare the variants against each other. The variants give the
+ * same results only if the callables are compiled without floating-point
+ * contraction, with `-ffp-contract=off` or `#pragma STDC FP_CONTRACT OFF`.
+ * Both GCC outside of ISO modes (`-ffp-contract=fast`) and Clang
+ * (`-ffp-contract=on`) contract `a * b + c` by default, which the AVX2 and
+ * AVX-512 variants, having FMA instructions, then round once instead of
+ * twice.
+ */
+
+#ifndef INVOKE_FORALL_SIMD_H
+#define INVOKE_FORALL_SIMD_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define INVOKE_FORALL_SIMD_X86 1
+#else
+#define INVOKE_FORALL_SIMD_X86 0
+#endif
+
+/** Instruction sets the vectorized kernels are compiled for. */
+enum class simd_isa {
+    /* Whatever the translation unit is compiled for. */
+    baseline,
+    /* AVX2 with FMA. */
+    avx2,
+    /* AVX-512 F, VL, BW and DQ. */
+    avx512,
+};
+
+namespace detail
+{
+
+inline constexpr std::size_t simd_isa_count = 3;
+
+/** Best variant supported by the CPU, read from cpuid. */
+inline simd_isa detect_simd_isa()
+{
+#if INVOKE_FORALL_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512dq")) {
+        return simd_isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return simd_isa::avx2;
+    }
+#endif
+    return simd_isa::baseline;
+}
+
+/**
+ * Detected once during static initialization. Kernels used by other static
+ * initializers before that read `baseline`, which is always safe.
+ */
+inline const simd_isa startup_simd_isa = detect_simd_isa();
+
+/** Satisfied if `T` is an `std::array` of arithmetic values. */
+template <typename T>
+struct is_simd_array : std::false_type {};
+
+template <typename T, std::size_t N>
+requires std::is_arithmetic_v<T>
+struct is_simd_array<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+concept SimdArray = is_simd_array<std::remove_cvref_t<T>>::value;
+
+/** The argument `arg` as used in the `i`-th invoke. */
+template <typename T>
+constexpr decltype(auto) simd_at(T& arg, std::size_t i)
+{
+    if constexpr (SimdArray<T>) {
+        return (arg[i]);
+    } else {
+        return (arg);
+    }
+}
+
+template <typename T>
+using simd_at_t = decltype(simd_at(std::declval<T&>(), 0));
+
+template <typename... Args>
+using simd_value_t =
+    decltype(std::invoke(std::declval<simd_at_t<Args>>()...));
+
+/**
+ * Satisfied if the invokes on `Args` can be performed by the vectorized
+ * kernels.
+ */
+template <typename... Args>
+concept SimdKernel =
+    (... || SimdArray<Args>) && (... && (SimdArray<Args> || !Gettable<Args>)) &&
+    SameArity<Args...> && requires { typename simd_value_t<Args...>; } &&
+    std::is_arithmetic_v<simd_value_t<Args...>>;
+
+template <typename R, std::size_t N, typename... Args>
+using simd_kernel_t = std::array<R, N> (*)(Args&...);
+
+/**
+ * Elements per block of the main loop. Its trip count is then a multiple of
+ * any vector length, so the loop is vectorized even where the compiler does
+ * not generate remainder loops (like GCC at `-O2`).
+ */
+inline constexpr std::size_t simd_block = 64;
+
+/** The loop shared by all variants, inlined into each of them. */
+template <typename R, std::size_t N, typename... Args>
+[[gnu::always_inline]] inline std::array<R, N> simd_loop(Args&...args)
+{
+    constexpr std::size_t main = N - N % simd_block;
+
+    std::array<R, N> out;
+
+    for (std::size_t i = 0; i < main; ++i) {
+        out[i] = std::invoke(simd_at(args, i)...);
+    }
+    for (std::size_t i = main; i < N; ++i) {
+        out[i] = std::invoke(simd_at(args, i)...);
+    }
+    return out;
+}
+
+template <typename R, std::size_t N, typename... Args>
+std::array<R, N> simd_kernel_baseline(Args&...args)
+{
+    return simd_loop<R, N>(args...);
+}
+
+#if INVOKE_FORALL_SIMD_X86
+template <typename R, std::size_t N, typename... Args>
+[[gnu::target("avx2,fma")]] std::array<R, N>
+simd_kernel_avx2(Args&...args)
+{
+    return simd_loop<R, N>(args...);
+}
+
+template <typename R, std::size_t N, typename... Args>
+[[gnu::target("avx512f,avx512vl,avx512bw,avx512dq")]] std::array<R, N>
+simd_kernel_avx512(Args&...args)
+{
+    return simd_loop<R, N>(args...);
+}
+#endif
+
+/** Kernels indexed by `simd_isa`, the baseline where unavailable. */
+template <typename R, std::size_t N, typename... Args>
+inline constexpr std::array<simd_kernel_t<R, N, Args...>, simd_isa_count>
+    simd_kernels{
+        &simd_kernel_baseline<R, N, Args...>,
+#if INVOKE_FORALL_SIMD_X86
+        &simd_kernel_avx2<R, N, Args...>,
+        &simd_kernel_avx512<R, N, Args...>,
+#else
+        &simd_kernel_baseline<R, N, Args...>,
+        &simd_kernel_baseline<R, N, Args...>,
+#endif
+    };
+
+template <typename... Args>
+auto invoke_simd_kernel(simd_isa isa, Args&...args)
+{
+    using value_type = std::remove_cvref_t<simd_value_t<Args...>>;
+    constexpr std::size_t arity = first_arity_v<Args...>;
+
+    return simd_kernels<value_type, arity, Args...>[static_cast<std::size_t>(
+        isa)](args...);
+}
+
+/** Same as above, with the variant detected at startup, cached per kernel. */
+template <typename... Args>
+auto invoke_simd_dispatched(Args&...args)
+{
+    using value_type = std::remove_cvref_t<simd_value_t<Args...>>;
+    constexpr std::size_t arity = first_arity_v<Args...>;
+
+    static const simd_kernel_t<value_type, arity, Args...> kernel =
+        simd_kernels<value_type, arity, Args...>[static_cast<std::size_t>(
+            startup_simd_isa)];
+
+    return kernel(args...);
+}
+
+} /* namespace detail */
+
+/** The best variant supported by this CPU, detected at startup. */
+inline simd_isa simd_detected_isa()
+{
+    return detail::startup_simd_isa;
+}
+
+/** True if the variant `isa` can run on this CPU. */
+inline bool simd_supported(simd_isa isa)
+{
+    return static_cast<int>(isa) <= static_cast<int>(simd_detected_isa());
+}
+
+/**
+ * Same as `invoke_forall(args...)`, with the invokes performed by the
+ * variant `isa` of the vectorized kernel. Throws `std::invalid_argument` if
+ * this CPU does not support `isa`.
+ */
+template <typename... Args>
+requires detail::NonEmpty<Args...> && detail::SimdKernel<Args...>
+auto invoke_forall_simd(simd_isa isa, Args&&...args)
+{
+    if (!simd_supported(isa)) {
+        throw std::invalid_argument("simd variant not supported by this CPU");
+    }
+    return detail::invoke_simd_kernel(isa, args...);
+}
+
+/**
+ * Same as `invoke_forall(args...)`, using the best vectorized kernel for
+ * this CPU where possible, see the top of this file.
+ */
+template <typename... Args>
+requires detail::NonEmpty<Args...> && detail::SameArity<Args...>
+constexpr decltype(auto) invoke_forall_simd(Args&&...args)
+{
+    if constexpr (detail::SimdKernel<Args...>) {
+        if !consteval {
+            return detail::invoke_simd_dispatched(args...);
+        }
+    }
+    return invoke_forall(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_SIMD_H */
@@ -0,0 +1,110 @@
+/**
+ * Contiguous reference results of `invoke_forall`.
+ *
+ * `invoke_forall_span` returns a `std::span` over an array instead of an
+ * array of `std::reference_wrapper` when the callable is known at compile
+ * time to return the elements of that array.
+ */
+
+#ifndef INVOKE_FORALL_SPAN_H
+#define INVOKE_FORALL_SPAN_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Opt-in trait for callables that return the element they are passed by
+ * reference, such as `std::identity`. Specialize it as `std::true_type`
+ * for other accessors to let `invoke_forall_span` return a `std::span`.
+ */
+INVOKE_FORALL_EXPORT template <typename F>
+struct is_element_accessor : std::false_type {};
+
+template <>
+struct is_element_accessor<std::identity> : std::true_type {};
+
+INVOKE_FORALL_EXPORT template <typename F>
+inline constexpr bool is_element_accessor_v =
+    is_element_accessor<std::remove_cvref_t<F>>::value;
+
+namespace detail
+{
+
+template <typename T>
+struct is_reference_array : std::false_type {};
+
+template <typename T, std::size_t N>
+struct is_reference_array<std::array<std::reference_wrapper<T>, N>>
+    : std::true_type {};
+
+template <typename T>
+struct is_std_array : std::false_type {};
+
+template <typename T, std::size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+/** Type of the elements of the array `A`, `const` if `A` is. */
+template <typename A>
+using array_element_t = std::remove_reference_t<decltype(std::get<0>(
+    std::declval<A&>()))>;
+
+/**
+ * Satisfied if `F` is an element accessor, `A` is an lvalue `std::array`
+ * and `invoke_forall(f, a)` returns references of exactly its element
+ * type, so the results are the elements of `a` in order.
+ */
+template <typename F, typename A>
+concept ArrayAccessor =
+    is_element_accessor_v<F> && std::is_lvalue_reference_v<A> &&
+    is_std_array<std::remove_cvref_t<A>>::value &&
+    std::tuple_size_v<std::remove_cvref_t<A>> != 0 &&
+    std::is_same_v<
+        decltype(invoke_forall(std::declval<F>(), std::declval<A>())),
+        std::array<std::reference_wrapper<array_element_t<A>>,
+                   std::tuple_size_v<std::remove_cvref_t<A>>>>;
+
+/** The results are known to be the elements, so nothing is invoked. */
+template <typename F, typename A>
+requires ArrayAccessor<F, A>
+constexpr auto invoke_forall_span(F&&, A&& arr) noexcept
+{
+    return std::span(arr);
+}
+
+template <typename... Args>
+requires NonEmpty<Args...> && SameArity<Args...> && (!NoneGettable<Args...>)
+constexpr auto invoke_forall_span(Args&&...args)
+{
+    auto refs = invoke_forall(std::forward<Args>(args)...);
+
+    static_assert(is_reference_array<decltype(refs)>::value,
+                  "all invokes of invoke_forall_span have to return the same "
+                  "lvalue reference type");
+
+    return refs;
+}
+
+} /* namespace detail */
+
+/**
+ * Same as `invoke_forall(args...)` for invokes that all return `T&`. If
+ * the callable is an element accessor (see `is_element_accessor`) and the
+ * only other argument is an lvalue `std::array<T, N>` whose elements it
+ * returns, the result is a `std::span<T, N>` over the array, and the
+ * accessor is not invoked. Otherwise the result is the array of
+ * `std::reference_wrapper<T>` returned by `invoke_forall`. The choice is
+ * made at compile time.
+ */
+INVOKE_FORALL_EXPORT template <typename... Args>
+constexpr auto invoke_forall_span(Args&&...args)
+{
+    return detail::invoke_forall_span(std::forward<Args>(args)...);
+}
+
+#endif /* INVOKE_FORALL_SPAN_H */
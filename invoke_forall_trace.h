@@ -0,0 +1,191 @@
+/**
+ * Opt-in tracing of the individual invokes performed by `invoke_forall`.
+ *
+ * `invoke_forall_traced(tracer, f, args...)` behaves like
+ * `invoke_forall(f, args...)`, but calls `tracer.on_begin()` and
+ * `tracer.on_end()` around the `i`-th invoke with the index `i`, the names
+ * of the argument types and a timestamp. Plain `invoke_forall` is never
+ * traced, and defining `INVOKE_FORALL_NO_TRACE` makes `invoke_forall_traced`
+ * ignore its tracer, so in both cases tracing compiles to nothing.
+ *
+ * The module also provides `chrome_trace_writer`, a tracer that writes
+ * Chrome trace-event JSON, which can be loaded in `chrome://tracing` or
+ * Perfetto to see the latency of every index.
+ */
+
+#ifndef INVOKE_FORALL_TRACE_H
+#define INVOKE_FORALL_TRACE_H
+
+#include "invoke_forall.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** A single hook call made by `invoke_forall_traced()`. */
+struct trace_event {
+    std::size_t index;
+    /* Names of the callable's type and of its argument types, in order. */
+    std::span<const std::string_view> arg_types;
+    std::chrono::steady_clock::time_point time;
+};
+
+/** Satisfied if `T` can be passed to `invoke_forall_traced()`. */
+template <typename T>
+concept Tracer = requires(T& tracer, const trace_event& event) {
+    tracer.on_begin(event);
+    tracer.on_end(event);
+};
+
+namespace detail
+{
+
+/** Returns the name of `T` as spelled by the compiler. */
+template <typename T>
+constexpr std::string_view type_name()
+{
+    std::string_view name = __PRETTY_FUNCTION__;
+
+    std::size_t begin = name.find("T = ") + 4;
+    std::size_t end = name.find(';', begin);
+    if (end == std::string_view::npos) {
+        end = name.rfind(']');
+    }
+
+    return name.substr(begin, end - begin);
+}
+
+template <typename... Ts>
+inline constexpr std::array<std::string_view, sizeof...(Ts)> type_names{
+    type_name<Ts>()...
+};
+
+/** Adapts a `Tracer` to the hooks interface of `invoke_forall_hooked()`. */
+template <Tracer T>
+struct trace_hooks {
+    T& tracer;
+
+    template <std::size_t I, typename... Ts>
+    void enter()
+    {
+        tracer.on_begin({ I, type_names<Ts...>,
+                          std::chrono::steady_clock::now() });
+    }
+
+    template <std::size_t I, typename... Ts>
+    void exit()
+    {
+        tracer.on_end({ I, type_names<Ts...>,
+                        std::chrono::steady_clock::now() });
+    }
+};
+
+/** Writes `s` as a JSON string literal. */
+inline void write_json_string(std::ostream& out, std::string_view s)
+{
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+/**
+ * Writes `d` in microseconds with exactly three decimals, computed from
+ * integer nanoseconds, so that long traces keep nanosecond resolution and
+ * never switch to exponent notation.
+ */
+inline void write_micros(std::ostream& out,
+                         std::chrono::steady_clock::duration d)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    auto fraction = ns % 1000;
+
+    out << ns / 1000 << '.' << static_cast<char>('0' + fraction / 100)
+        << static_cast<char>('0' + fraction / 10 % 10)
+        << static_cast<char>('0' + fraction % 10);
+}
+
+} /* namespace detail */
+
+/**
+ * Tracer that writes every invoke as a complete ("X") event of the Chrome
+ * trace-event format. The JSON document is closed on destruction.
+ *
+ * Timestamps are in microseconds since the construction of the writer,
+ * written with three decimals (nanoseconds). Not thread-safe.
+ */
+class chrome_trace_writer {
+public:
+    explicit chrome_trace_writer(std::ostream& out)
+        : out(out), start(std::chrono::steady_clock::now())
+    {
+        out << "{\"traceEvents\":[";
+    }
+
+    chrome_trace_writer(const chrome_trace_writer&) = delete;
+    chrome_trace_writer& operator=(const chrome_trace_writer&) = delete;
+
+    ~chrome_trace_writer() { out << "\n]}\n"; }
+
+    void on_begin(const trace_event& event) { begins.push_back(event.time); }
+
+    void on_end(const trace_event& event)
+    {
+        auto begin = begins.back();
+        begins.pop_back();
+
+        out << (first ? "\n" : ",\n");
+        first = false;
+
+        out << "{\"name\":\"invoke_at<" << event.index << ">\""
+            << ",\"cat\":\"invoke_forall\",\"ph\":\"X\",\"ts\":";
+        detail::write_micros(out, begin - start);
+        out << ",\"dur\":";
+        detail::write_micros(out, event.time - begin);
+        out << ",\"pid\":1,\"tid\":1"
+            << ",\"args\":{\"index\":" << event.index << ",\"types\":[";
+
+        for (std::size_t i = 0; i < event.arg_types.size(); ++i) {
+            if (i != 0) {
+                out << ',';
+            }
+            detail::write_json_string(out, event.arg_types[i]);
+        }
+
+        out << "]}}";
+    }
+
+private:
+    std::ostream& out;
+    std::chrono::steady_clock::time_point start;
+    /* Begin times of the invokes in progress, nested calls included. */
+    std::vector<std::chrono::steady_clock::time_point> begins;
+    bool first = true;
+};
+
+/**
+ * Same as `invoke_forall(args...)`, but reports every invoke to `tracer`.
+ * During constant evaluation the tracer is not called.
+ */
+template <Tracer T, typename... Args>
+constexpr decltype(auto) invoke_forall_traced([[maybe_unused]] T& tracer,
+                                              Args&&...args)
+{
+#ifdef INVOKE_FORALL_NO_TRACE
+    return invoke_forall(std::forward<Args>(args)...);
+#else
+    detail::trace_hooks<T> hooks{ tracer };
+    return detail::invoke_forall_hooked(hooks, std::forward<Args>(args)...);
+#endif
+}
+
+#endif /* INVOKE_FORALL_TRACE_H */
@@ -0,0 +1,341 @@
+/**
+ * Benchmarks of `invoke_forall` over different argument shapes.
+ *
+ * For every case reports the wall-clock time per `invoke_forall` call and,
+ * when run with `--perf` on Linux, hardware counters read through
+ * `perf_event_open`: cycles, instructions, branch misses, L1d and LLC read
+ * misses and iTLB misses. Counters that can not be opened (missing
+ * permission, unsupported event, virtual machine) are reported as `n/a`
+ * and the benchmark falls back to wall-clock numbers only.
+ *
+ * All figures are per `invoke_forall` call and, in the `/inv` columns,
+ * per single invoke, which makes it possible to tell the cost of the
+ * generated code apart from the cost of the data.
+ *
+ * The `parallel` cases run one task per invoke on a pool with one thread per
+ * core, with the same callable and arguments, through the code path of
+ * `invoke_forall_padded` once with its cache-line-padded results and once
+ * with the results in adjacent `std::array` elements, so the difference
+ * between the two is the effect of the padding alone. It only shows on
+ * machines with many cores (8 or more). The counters are inherited by
+ * threads created after they are opened, so they are opened before the pool
+ * and cover its workers.
+ */
+
+#include "../../invoke_forall.h"
+#include "../../invoke_forall_parallel.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+/** Prevents the compiler from optimizing `value` away. */
+template <typename T>
+void escape(T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+struct counter_spec {
+    const char *name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+#ifdef __linux__
+
+constexpr std::uint64_t cache_config(std::uint64_t cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const std::array<counter_spec, 6> counter_specs{ {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instr", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "br-miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "L1d-miss", PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_L1D) },
+    { "LLC-miss", PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_LL) },
+    { "iTLB-miss", PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_ITLB) },
+} };
+
+/**
+ * A set of hardware counters of the calling thread and of every thread it
+ * creates afterwards. Each counter is opened on its own, so that one
+ * unsupported event does not disable the others; values are scaled by the
+ * enabled/running ratio in case the kernel multiplexes them.
+ */
+class perf_counters {
+public:
+    explicit perf_counters(bool enabled)
+    {
+        fds.fill(-1);
+        if (!enabled) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < counter_specs.size(); ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = counter_specs[i].type;
+            attr.config = counter_specs[i].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            fds[i] = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters()
+    {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool any_open() const
+    {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start()
+    {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    std::array<std::optional<double>, counter_specs.size()> stop()
+    {
+        std::array<std::optional<double>, counter_specs.size()> values;
+
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            std::uint64_t data[3];
+            if (read(fds[i], data, sizeof(data)) != sizeof(data) ||
+                data[2] == 0) {
+                continue;
+            }
+            values[i] = static_cast<double>(data[0]) *
+                        static_cast<double>(data[1]) /
+                        static_cast<double>(data[2]);
+        }
+
+        return values;
+    }
+
+private:
+    std::array<int, counter_specs.size()> fds;
+};
+
+#else
+
+const std::array<counter_spec, 0> counter_specs{};
+
+class perf_counters {
+public:
+    explicit perf_counters(bool) {}
+    bool any_open() const { return false; }
+    void start() {}
+    std::array<std::optional<double>, 0> stop() { return {}; }
+};
+
+#endif
+
+constexpr std::size_t default_iterations = 200000;
+
+/** Runs `body` `iterations` times and prints per-call and per-invoke figures. */
+template <typename Body>
+void run_case(perf_counters& counters, std::string_view name,
+              std::size_t invokes, Body body,
+              std::size_t iterations = default_iterations)
+{
+    for (std::size_t i = 0; i < iterations / 10; ++i) {
+        body();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    counters.start();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        body();
+    }
+    auto values = counters.stop();
+    auto end = std::chrono::steady_clock::now();
+
+    double per_call =
+        std::chrono::duration<double, std::nano>(end - begin).count() /
+        iterations;
+
+    std::printf("%-28.*s %10.2f %10.2f", static_cast<int>(name.size()),
+                name.data(), per_call, per_call / invokes);
+
+    for (const auto& value : values) {
+        if (value) {
+            std::printf(" %12.2f %10.3f", *value / iterations,
+                        *value / iterations / invokes);
+        } else {
+            std::printf(" %12s %10s", "n/a", "n/a");
+        }
+    }
+    std::printf("\n");
+}
+
+void print_header()
+{
+    std::printf("%-28s %10s %10s", "case", "ns/call", "ns/inv");
+    for (const auto& spec : counter_specs) {
+        std::string per_invoke = std::string(spec.name) + "/inv";
+        std::printf(" %12s %10s", spec.name, per_invoke.c_str());
+    }
+    std::printf("\n");
+}
+
+} /* anonymous namespace */
+
+int main(int argc, char *argv[])
+{
+    bool use_perf = argc > 1 && std::string_view(argv[1]) == "--perf";
+
+    perf_counters counters(use_perf);
+    if (use_perf && !counters.any_open()) {
+        std::fprintf(stderr, "perf_event_open is not available "
+                             "(check kernel.perf_event_paranoid), "
+                             "reporting wall-clock time only\n");
+    }
+
+    print_header();
+
+    std::array<int, 16> a16{};
+    std::array<int, 16> b16{};
+    std::array<int, 256> a256{};
+    std::array<int, 256> b256{};
+    for (int i = 0; i < 256; ++i) {
+        a256[i] = b256[i] = i;
+        if (i < 16) {
+            a16[i] = b16[i] = i;
+        }
+    }
+
+    run_case(counters, "array<int,16> plus", 16, [&] {
+        escape(a16);
+        auto res = invoke_forall(std::plus<int>{}, a16, b16);
+        escape(res);
+    });
+
+    run_case(counters, "array<int,256> plus", 256, [&] {
+        escape(a256);
+        auto res = invoke_forall(std::plus<int>{}, a256, b256);
+        escape(res);
+    });
+
+    run_case(counters, "array<int,256> + scalar", 256, [&] {
+        escape(a256);
+        int d = 3;
+        escape(d);
+        auto res = invoke_forall(std::plus<int>{}, a256, d);
+        escape(res);
+    });
+
+    auto tuple8 = std::tuple{ 1, 2L, 3.0f, 4.0, short{ 5 }, 6U, 7LL, 8.0 };
+    run_case(counters, "tuple<8 mixed> identity", 8, [&] {
+        escape(tuple8);
+        auto res = invoke_forall([](auto x) { return x + 1; }, tuple8);
+        escape(res);
+    });
+
+    auto tuple_int8 = std::tuple{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::array<int, 8> a8{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    run_case(counters, "tuple<int x8> identity", 8, [&] {
+        escape(tuple_int8);
+        auto res = invoke_forall([](auto x) { return x + 1; }, tuple_int8);
+        escape(res);
+    });
+
+    run_case(counters, "array<int,8> identity", 8, [&] {
+        escape(a8);
+        auto res = invoke_forall([](auto x) { return x + 1; }, a8);
+        escape(res);
+    });
+
+    run_case(counters, "array<int,256> lvalue refs", 256, [&] {
+        escape(a256);
+        auto res = invoke_forall([](int& x) -> int& { return x; }, a256);
+        escape(res);
+    });
+
+    run_case(counters, "array<int,16> + protected", 16, [&] {
+        escape(a16);
+        auto res = invoke_forall(
+            [](int x, const std::array<int, 256>& t) { return x + t[x]; },
+            a16, protect_arg(a256));
+        escape(res);
+    });
+
+    // opened before the pool, so that the counters are inherited by its
+    // workers
+    thread_pool pool;
+    parallel_policy per_invoke{ &pool, 1 };
+    auto busy = [](int x) {
+        for (int i = 0; i < 16; ++i) {
+            x = x * 31 + i;
+        }
+        return x;
+    };
+    std::array<int, 64> a64{};
+    for (int i = 0; i < 64; ++i) {
+        a64[i] = i;
+    }
+
+    run_case(counters, "parallel adjacent results", 64, [&] {
+        escape(a64);
+        auto res =
+            detail::invoke_forall_slots<std::array>(per_invoke, busy, a64);
+        escape(res);
+    }, 2000);
+
+    run_case(counters, "parallel padded results", 64, [&] {
+        escape(a64);
+        auto res = invoke_forall_padded(per_invoke, busy, a64);
+        escape(res);
+    }, 2000);
+}
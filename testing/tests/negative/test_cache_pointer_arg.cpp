@@ -0,0 +1,9 @@
+#include "invoke_forall_cache.h"
+#include <array>
+
+int main() {
+    // the hash would only cover the address, not the values behind it
+    std::array<int, 2> values{1, 2};
+    invoke_forall_cached("cache.ifc", "sum", [](const int *p) { return *p; },
+                         values.data());
+}
@@ -0,0 +1,9 @@
+#include "invoke_forall_common.h"
+#include <tuple>
+#include <vector>
+
+int main() {
+    // std::vector<int> can only be constructed from a size explicitly
+    invoke_forall_common<std::vector<int>>([](int x) { return x; },
+                                           std::tuple{1, 2});
+}
@@ -0,0 +1,14 @@
+#include "invoke_forall_inplace.h"
+#include <array>
+
+// every invoke would see the elements overwritten by the earlier ones, so
+// the check throws, which is not a constant expression
+constexpr std::array<int, 3> sums = [] {
+    std::array<int, 3> a{1, 2, 3};
+    invoke_forall_inplace([](int x, const std::array<int, 3>& all) {
+        return x + all[0];
+    }, a, protect_arg(a));
+    return a;
+}();
+
+int main() {}
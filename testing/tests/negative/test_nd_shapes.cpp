@@ -0,0 +1,9 @@
+#include "invoke_forall_nd.h"
+#include <array>
+#include <functional>
+
+int main() {
+    std::array<std::array<int, 3>, 2> a{};
+    std::array<std::array<int, 2>, 3> b{};
+    invoke_forall_nd(std::plus<int>{}, a, b);
+}
@@ -0,0 +1,10 @@
+#include "invoke_forall_nd.h"
+#include <array>
+#include <tuple>
+
+int main() {
+    // a tuple can not be zipped with the index space of the arrays
+    std::array<std::array<int, 2>, 2> m{};
+    invoke_forall_nd([](int x, const std::tuple<int, int>&) { return x; }, m,
+                     std::tuple{1, 2});
+}
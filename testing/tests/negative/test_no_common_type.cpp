@@ -0,0 +1,8 @@
+#include "invoke_forall_common.h"
+#include <string>
+#include <tuple>
+
+int main() {
+    invoke_forall_common([](auto x) { return x; },
+                         std::tuple{1, std::string("a")});
+}
@@ -0,0 +1,6 @@
+#include "invoke_forall_packed.h"
+#include <array>
+
+int main() {
+    invoke_forall_packed([](int x) { return x; }, std::array{1, 2, 3});
+}
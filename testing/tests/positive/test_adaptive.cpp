@@ -0,0 +1,117 @@
+#include "invoke_forall_parallel.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+std::atomic<bool> slow = true;
+
+int slow_square(int x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    return x * x;
+}
+
+// as slow as slow_square until `slow` is cleared
+int square(int x) {
+    return slow ? slow_square(x) : x * x;
+}
+
+// not vectorizable, the result is not arithmetic
+std::string slow_text(int x) {
+    return std::to_string(slow_square(x));
+}
+
+template <typename... Args>
+adaptive_stats& site_stats(const adaptive_policy& policy, Args&&...) {
+    return detail::adaptive_site_stats<Args...>.at(policy.site);
+}
+
+int main() {
+    thread_pool pool(4);
+    std::array<int, 16> a{};
+    for (int i = 0; i < 16; ++i) {
+        a[i] = i;
+    }
+
+    // cheap invokes over arithmetic arrays stay on the calling thread,
+    // vectorized
+    adaptive_stats cheap;
+    for (int i = 0; i < 10; ++i) {
+        auto res = invoke_forall(adaptive_policy{ &cheap, &pool },
+                                 std::plus<int>{}, a, 1);
+        assert(res[15] == 16);
+    }
+    assert(cheap.vectorized_runs() == 10);
+    assert(cheap.sequential_runs() == 0);
+    assert(cheap.pooled_runs() == 0);
+    assert(cheap.invoke_ns() >= 0);
+
+    // other cheap invokes stay sequential
+    adaptive_stats strings;
+    auto text = invoke_forall(adaptive_policy{ &strings, &pool },
+                              [](int x) { return std::to_string(x); }, a);
+    assert(text[12] == "12");
+    assert(strings.sequential_runs() == 1 && strings.vectorized_runs() == 0);
+
+    // expensive invokes move to the pool after the first measurement
+    adaptive_stats expensive;
+    for (int i = 0; i < 3; ++i) {
+        auto res = invoke_forall(adaptive_policy{ &expensive, &pool },
+                                 slow_text, a);
+        assert(res[3] == "9");
+    }
+    assert(expensive.sequential_runs() == 1);
+    assert(expensive.pooled_runs() == 2);
+    assert(expensive.last_grain() >= 1 && expensive.last_grain() <= 4);
+    assert(expensive.invoke_ns() > 100000);
+
+    // pinning overrides the statistics
+    expensive.pin(execution_mode::sequential);
+    invoke_forall(adaptive_policy{ &expensive, &pool }, slow_text, a);
+    assert(expensive.sequential_runs() == 2);
+    expensive.unpin();
+    invoke_forall(adaptive_policy{ &expensive, &pool }, slow_text, a);
+    assert(expensive.pooled_runs() == 3);
+
+    // pinned to vectorized, arguments that are not vectorizable run
+    // sequentially
+    expensive.pin(execution_mode::vectorized);
+    invoke_forall(adaptive_policy{ &expensive, &pool }, slow_text, a);
+    assert(expensive.sequential_runs() == 3);
+    expensive.unpin();
+
+    // only the invokes are timed in the pool, not the dispatch, so invokes
+    // that became cheap move back to the calling thread
+    adaptive_stats changing;
+    adaptive_policy latest{ &changing, &pool, 1.0 };
+    invoke_forall(latest, square, a);
+    invoke_forall(latest, square, a);
+    assert(changing.pooled_runs() == 1);
+    slow = false;
+    invoke_forall(latest, square, a);
+    assert(changing.pooled_runs() == 2);
+    assert(changing.invoke_ns() < 3000);
+    assert(invoke_forall(latest, square, a)[5] == 25);
+    assert(changing.vectorized_runs() == 2);
+
+    // without stats, every place creating a policy keeps its own statistics
+    slow = true;
+    adaptive_policy slow_site{ .pool = &pool };
+    adaptive_policy fast_site{ .pool = &pool };
+    for (int i = 0; i < 3; ++i) {
+        invoke_forall(slow_site, slow_text, a);
+    }
+    invoke_forall(fast_site, slow_text, a);
+    assert(&site_stats(slow_site, slow_text, a) !=
+           &site_stats(fast_site, slow_text, a));
+    assert(site_stats(slow_site, slow_text, a).pooled_runs() == 2);
+    assert(site_stats(fast_site, slow_text, a).pooled_runs() == 0);
+
+    // the shared default policy object keys them by argument types only
+    auto res = invoke_forall(adaptive, std::plus<int>{}, a, a);
+    assert(res[4] == 8);
+    assert(invoke_forall(adaptive, std::plus<int>{}, 2, 3) == 5);
+}
@@ -0,0 +1,137 @@
+#include "invoke_forall_batch.h"
+#include <array>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// a result without a default constructor
+struct tagged {
+    explicit tagged(int v) : value(v) {}
+    int value;
+};
+
+// counts live objects, to check that failed batches destroy their results
+struct counted {
+    static inline int live = 0;
+
+    explicit counted(int v) : value(std::make_shared<int>(v)) { ++live; }
+    counted(const counted& other) : value(other.value) { ++live; }
+    ~counted() { --live; }
+
+    std::shared_ptr<int> value;
+};
+
+int main() {
+    std::array<int, 3> cfg{1, 10, 100};
+    std::vector<std::array<int, 3>> rows;
+    for (int r = 0; r < 1000; ++r) {
+        rows.push_back({r, r + 1, r + 2});
+    }
+
+    auto res = invoke_forall_batch(std::multiplies<int>{}, cfg, batch_arg(rows));
+    assert(res.rows() == 1000);
+    assert(res.cols() == 3);
+    for (std::size_t r = 0; r < rows.size(); ++r) {
+        auto expected = invoke_forall(std::multiplies<int>{}, cfg, rows[r]);
+        for (std::size_t i = 0; i < 3; ++i) {
+            assert(res(r, i) == expected[i]);
+        }
+    }
+    assert(res.row(7)[2] == 900);
+
+    auto col = invoke_forall_batch(
+        sequenced, {.layout = batch_layout::column_major, .grain = 0},
+        std::multiplies<int>{}, cfg, batch_arg(rows));
+    assert(col.column(1).size() == 1000);
+    assert(col.column(1)[7] == 80);
+    assert(col(7, 1) == res(7, 1));
+
+    // scalar rows, one invoke per row, custom buffer and grain
+    std::vector<int> xs{1, 2, 3, 4, 5};
+    std::vector<long> out(xs.size());
+    invoke_forall_batch_into(parallel, std::span<long>(out), {.grain = 2},
+                             [](int x, int d) -> long { return x * d; },
+                             batch_arg(xs), 3);
+    assert((out == std::vector<long>{3, 6, 9, 12, 15}));
+
+    // bool results are stored as real bools, not as std::vector<bool> bits
+    auto odd = invoke_forall_batch([](int x) { return x % 2 == 1; },
+                                   batch_arg(xs));
+    static_assert(std::is_same_v<decltype(odd.data()), std::span<bool>>);
+    static_assert(std::is_same_v<decltype(odd(0, 0)), bool&>);
+    assert(odd(0, 0) && !odd(1, 0) && odd(4, 0));
+    odd(1, 0) = true;
+    assert(odd.data()[1]);
+
+    // results are constructed in place, no default constructor needed
+    auto tags = invoke_forall_batch(
+        sequenced, {.layout = batch_layout::column_major, .grain = 2},
+        [](int x, int k) { return tagged(x * k); }, batch_arg(xs),
+        std::array{1, -1});
+    assert(tags(4, 0).value == 5 && tags(4, 1).value == -5);
+
+    // lvalue reference results are stored as reference_wrappers
+    std::array<int, 3> table{10, 20, 30};
+    auto refs = invoke_forall_batch(
+        [&](int x, int i) -> int& { return table[(x + i) % 3]; },
+        batch_arg(xs), std::array{0, 1});
+    static_assert(std::is_same_v<decltype(refs(0, 0)),
+                                 std::reference_wrapper<int>&>);
+    assert(&refs(0, 0).get() == &table[1]);
+    refs(2, 1).get() = 7;
+    assert(table[1] == 7);
+
+    // a failing batch leaves no result alive, in every layout
+    for (auto layout : {batch_layout::row_major, batch_layout::column_major}) {
+        bool failed = false;
+        try {
+            invoke_forall_batch(parallel, {.layout = layout, .grain = 1},
+                                [](int x, int k) {
+                                    if (x == 3 && k == 2) {
+                                        throw std::runtime_error("3");
+                                    }
+                                    return counted(x * k);
+                                },
+                                batch_arg(xs), std::array{1, 2, 3});
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        assert(failed && counted::live == 0);
+    }
+    {
+        auto alive = invoke_forall_batch(
+            [](int x) { return counted(x); }, batch_arg(xs));
+        assert(counted::live == 5 && *alive(4, 0).value == 5);
+        auto moved = std::move(alive);
+        assert(counted::live == 5 && moved.rows() == 5);
+    }
+    assert(counted::live == 0);
+
+    // several batched arguments have to have the same size
+    std::vector<int> shorter{1, 2};
+    bool thrown = false;
+    try {
+        invoke_forall_batch(std::plus<int>{}, batch_arg(xs), batch_arg(shorter));
+    } catch (const std::length_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // exceptions of a row are rethrown
+    thrown = false;
+    try {
+        invoke_forall_batch([](int x) {
+            if (x == 4) {
+                throw std::runtime_error("4");
+            }
+            return x;
+        }, batch_arg(xs));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
@@ -0,0 +1,101 @@
+#include "invoke_forall_cache.h"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+int calls = 0;
+
+enum class dir : unsigned char { up, down };
+
+int scale(int x, int factor) {
+    ++calls;
+    return x * factor;
+}
+
+int main() {
+    auto file = std::filesystem::temp_directory_path() /
+                ("invoke_forall_cache_test." + std::to_string(getpid()));
+    std::filesystem::remove(file);
+
+    std::array<int, 4> values{1, 2, 3, 4};
+
+    auto res1 = invoke_forall_cached(file, "scale", scale, values, 10);
+    assert(!res1.from_cache());
+    assert((*res1 == std::array{10, 20, 30, 40}));
+    assert(calls == 4);
+
+    auto res2 = invoke_forall_cached(file, "scale", scale, values, 10);
+    assert(res2.from_cache());
+    assert((*res2 == std::array{10, 20, 30, 40}));
+    assert(calls == 4);
+
+    // different argument values make the entry stale
+    auto res3 = invoke_forall_cached(file, "scale", scale, values, 100);
+    assert(!res3.from_cache());
+    assert(res3->at(3) == 400);
+    assert(calls == 8);
+
+    // different result type makes the entry stale
+    auto res4 = invoke_forall_cached(
+        file, "scale", [](int x) { return static_cast<long>(x); }, values);
+    assert(!res4.from_cache());
+
+    // Gettable arguments with non-trivially copyable elements
+    auto res5 = invoke_forall_cached(
+        file, "size", [](const std::string& s) { return s.size(); },
+        std::tuple{std::string("a"), std::string("bcd")});
+    assert(!res5.from_cache());
+    assert((*res5 == std::array<std::size_t, 2>{1, 3}));
+    assert(invoke_forall_cached(
+        file, "size", [](const std::string& s) { return s.size(); },
+        std::tuple{std::string("a"), std::string("bcd")}).from_cache());
+
+    // lambdas of the same type spelling are told apart by their keys
+    auto twice = [](int x) { return 2 * x; };
+    auto thrice = [](int x) { return 3 * x; };
+    assert(!invoke_forall_cached(file, "twice", twice, values).from_cache());
+    auto res7 = invoke_forall_cached(file, "thrice", thrice, values);
+    assert(!res7.from_cache());
+    assert((*res7 == std::array{3, 6, 9, 12}));
+
+    // C strings are hashed by their characters, not their address
+    char first[] = "abc";
+    char second[] = "abc";
+    auto length = [](const char *s) { return std::string_view(s).size(); };
+    assert(!invoke_forall_cached(file, "length", length, +first).from_cache());
+    assert(invoke_forall_cached(file, "length", length, +second).from_cache());
+    second[2] = '\0';
+    assert(!invoke_forall_cached(file, "length", length, +second).from_cache());
+
+    // enum results, and floating-point arguments by their bits
+    auto sign = [](double x) { return std::signbit(x) ? dir::down : dir::up; };
+    assert(*invoke_forall_cached(file, "sign", sign, 0.0) == dir::up);
+    auto res8 = invoke_forall_cached(file, "sign", sign, -0.0);
+    assert(!res8.from_cache() && *res8 == dir::down);
+
+    // corrupt payload is detected and recomputed
+    invoke_forall_cached(file, "scale", scale, values, 10);
+    {
+        std::fstream f(file, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(sizeof(detail::cache_header));
+        f.put('\x7f');
+    }
+    calls = 0;
+    auto res6 = invoke_forall_cached(file, "scale", scale, values, 10);
+    assert(!res6.from_cache());
+    assert((*res6 == std::array{10, 20, 30, 40}));
+    assert(calls == 4);
+
+    // truncated file is detected as well
+    std::filesystem::resize_file(file, sizeof(detail::cache_header));
+    assert(!invoke_forall_cached(file, "scale", scale, values, 10).from_cache());
+    assert(invoke_forall_cached(file, "scale", scale, values, 10).from_cache());
+
+    std::filesystem::remove(file);
+}
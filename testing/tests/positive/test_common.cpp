@@ -0,0 +1,49 @@
+#include "invoke_forall_common.h"
+#include <array>
+#include <cassert>
+#include <string>
+#include <tuple>
+
+int main() {
+    constexpr auto twice = [](auto x) { return x * 2; };
+
+    // int and long results become an array of long
+    constexpr auto longs = invoke_forall_common(twice, std::tuple{1, 2L, 3});
+    static_assert(std::is_same_v<decltype(longs), const std::array<long, 3>>);
+    static_assert(longs == std::array{2L, 4L, 6L});
+
+    constexpr auto doubles = invoke_forall_common(twice,
+                                                  std::tuple{1.5f, 2.0});
+    static_assert(std::is_same_v<decltype(doubles),
+                                 const std::array<double, 2>>);
+
+    // a user-specified element type
+    constexpr auto floats = invoke_forall_common<float>(
+        twice, std::tuple{1, 2.5, 3L});
+    static_assert(floats == std::array{2.0f, 5.0f, 6.0f});
+
+    // homogeneous results and non-Gettable arguments
+    std::array<int, 4> a{1, 2, 3, 4};
+    auto same = invoke_forall_common(std::plus<int>{}, a, 1);
+    assert(same == (std::array{2, 3, 4, 5}));
+
+    static_assert(invoke_forall_common(std::plus<int>{}, 2, 3) ==
+                  std::array{5});
+
+    // lvalue results are copied
+    auto copies = invoke_forall_common([](int& x) -> int& { return x; }, a);
+    static_assert(std::is_same_v<decltype(copies), std::array<int, 4>>);
+    copies[0] = 10;
+    assert(a[0] == 1);
+
+    auto strings = invoke_forall_common<std::string>(
+        [](auto x) { return x; },
+        std::tuple{"ab", std::string("cd")});
+    assert(strings[0] + strings[1] == "abcd");
+
+    long sum = 0;
+    for (long x : longs) {
+        sum += x;
+    }
+    assert(sum == 12);
+}
@@ -0,0 +1,95 @@
+#include "invoke_forall_compact.h"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+constexpr auto widen = [](auto x) {
+    if constexpr (sizeof(x) == 1) {
+        return x;
+    } else {
+        return double(x);
+    }
+};
+
+using mixed = compact_tuple<char, double, char, double>;
+
+// the layout needs no padding between members, indices are unchanged
+static_assert(sizeof(mixed) == 24);
+static_assert(sizeof(std::tuple<char, double, char, double>) == 32);
+static_assert(mixed::bytes_saved == 8);
+static_assert(std::tuple_size_v<mixed> == 4);
+static_assert(std::is_same_v<std::tuple_element_t<1, mixed>, double>);
+static_assert(detail::Gettable<mixed>);
+static_assert(sizeof(compact_tuple<std::int8_t, std::int32_t, std::int16_t,
+                                   std::int64_t, std::int8_t>) == 16);
+static_assert(compact_tuple<int, int>::bytes_saved == 0);
+
+// a user-defined Gettable type found through its own get, like
+// compact_tuple, without declaring anything in namespace std
+namespace user
+{
+struct pair_like {
+    int first;
+    double second;
+
+    template <std::size_t I>
+    friend constexpr auto get(const pair_like& p)
+    {
+        if constexpr (I == 0) {
+            return p.first;
+        } else {
+            return p.second;
+        }
+    }
+};
+} // namespace user
+
+template <>
+struct std::tuple_size<user::pair_like>
+    : std::integral_constant<std::size_t, 2> {};
+
+static_assert(detail::Gettable<user::pair_like>);
+static_assert(invoke_forall(widen, user::pair_like{ 2, 0.5 }) ==
+              std::array{ 2.0, 0.5 });
+
+int main() {
+    // compile time
+    constexpr auto c = invoke_forall_compact(
+        widen, std::tuple{ 'a', 1.5f, 'b', 2 });
+    static_assert(std::is_same_v<decltype(c), const mixed>);
+    static_assert(get<0>(c) == 'a' && c.get<1>() == 1.5);
+    static_assert(get<2>(c) == 'b' && get<3>(c) == 2.0);
+    static_assert(c == mixed{ 'a', 1.5, 'b', 2.0 });
+
+    // fed back into invoke_forall by the original indices
+    auto doubled = invoke_forall([](auto x) { return x + x; }, c);
+    assert(get<1>(doubled) == 3.0 && get<2>(doubled) == 'b' + 'b');
+
+    // structured bindings, references and non-trivial members
+    int x = 1;
+    std::string s = "s";
+    auto refs = invoke_forall_compact(
+        [](auto& v) -> auto& { return v; },
+        std::forward_as_tuple(x, s));
+    static_assert(std::is_same_v<decltype(refs),
+                                 compact_tuple<int&, std::string&>>);
+    auto& [rx, rs] = refs;
+    rx = 7;
+    rs += "t";
+    assert(x == 7 && s == "st");
+
+    compact_tuple<char, std::string, std::int16_t> moved{ 'c', "long string",
+                                                          3 };
+    compact_tuple<char, std::string, std::int16_t> copy = moved;
+    std::string taken = get<1>(std::move(moved));
+    assert(taken == "long string" && get<1>(copy) == "long string");
+    assert(get<2>(copy) == 3);
+
+    // a single invoke, and value-initialized defaults
+    auto one = invoke_forall_compact([](int a, int b) { return a + b; }, 2, 3);
+    assert(get<0>(one) == 5);
+    assert(get<3>(mixed{}) == 0.0);
+}
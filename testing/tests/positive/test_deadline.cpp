@@ -0,0 +1,63 @@
+#include "invoke_forall_deadline.h"
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <tuple>
+
+using namespace std::chrono_literals;
+
+int main() {
+    std::array<int, 6> a{1, 2, 3, 4, 5, 6};
+    auto far = std::chrono::steady_clock::now() + 1h;
+
+    auto all = invoke_forall_with_deadline(far, std::plus<int>{}, a, 1);
+    static_assert(std::is_same_v<decltype(all.values),
+                                 std::array<std::optional<int>, 6>>);
+    assert(all.completed == 6);
+    assert(*all.values[5] == 7);
+
+    // the clock is checked between invokes
+    auto slow = [](int x) {
+        std::this_thread::sleep_for(20ms);
+        return x;
+    };
+    auto partial = invoke_forall_with_deadline(
+        std::chrono::steady_clock::now() + 50ms, slow, a);
+    assert(partial.completed >= 1 && partial.completed < 6);
+    assert(*partial.values[0] == 1);
+    assert(!partial.values[5]);
+    for (std::size_t i = 0; i < partial.completed; ++i) {
+        assert(partial.values[i]);
+    }
+
+    // callables taking a stop token are told about the deadline
+    auto cooperative = [](int x, std::stop_token token) {
+        while (!token.stop_requested()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        return x;
+    };
+    auto stopped = invoke_forall_with_deadline(
+        std::chrono::steady_clock::now() + 30ms, cooperative, a);
+    assert(stopped.completed == 1);
+    assert(*stopped.values[0] == 1);
+
+    // queued tasks of a parallel policy are skipped
+    thread_pool pool(2);
+    auto par = invoke_forall_with_deadline(
+        parallel_policy{ &pool }, std::chrono::steady_clock::now() + 30ms,
+        slow, std::array<int, 16>{});
+    assert(par.completed >= 1 && par.completed < 16);
+
+    auto het = invoke_forall_with_deadline(far, [](auto x) { return x; },
+                                           std::tuple{1, std::string("s")});
+    assert(het.completed == 2);
+    assert(*std::get<1>(het.values) == "s");
+
+    auto expired = invoke_forall_with_deadline(
+        std::chrono::steady_clock::now() - 1s, std::plus<int>{}, a, 1);
+    assert(expired.completed == 0 && !expired.values[0]);
+}
@@ -0,0 +1,130 @@
+#include "invoke_forall_expected.h"
+#include <array>
+#include <cassert>
+#include <expected>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <variant>
+
+int checked_div(int a, int b) {
+    if (b == 0) {
+        throw std::domain_error("division by zero");
+    }
+    return a / b;
+}
+
+std::expected<int, std::exception_ptr> parse_digit(char c) {
+    if (c < '0' || c > '9') {
+        return std::unexpected(
+            std::make_exception_ptr(std::invalid_argument("not a digit")));
+    }
+    return c - '0';
+}
+
+enum class parse_error { not_a_digit };
+
+// returns ordinary errors and throws on characters it does not expect
+std::expected<int, parse_error> parse_code(char c) {
+    if (c == '!') {
+        throw std::invalid_argument("unexpected character");
+    }
+    if (c < '0' || c > '9') {
+        return std::unexpected(parse_error::not_a_digit);
+    }
+    return c - '0';
+}
+
+template <typename E>
+bool holds(const std::exception_ptr& p) {
+    try {
+        std::rethrow_exception(p);
+    } catch (const E&) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+constexpr bool test_constexpr() {
+    auto res = invoke_forall_expected(
+        [](int a, int b) { return a + b; }, std::array{1, 2}, 10);
+    return res[0].value() == 11 && res[1].value() == 12;
+}
+
+int main() {
+    static_assert(test_constexpr());
+
+    // all invokes run, the failing one holds its exception
+    auto res1 = invoke_forall_expected(checked_div, 12, std::array{3, 0, 4});
+    static_assert(std::is_same_v<
+        decltype(res1), std::array<std::expected<int, std::exception_ptr>, 3>>);
+    assert(res1[0].value() == 4);
+    assert(!res1[1].has_value());
+    assert(holds<std::domain_error>(res1[1].error()));
+    assert(res1[2].value() == 3);
+
+    // fail-fast skips the invokes after the first failure
+    int calls = 0;
+    auto counting_div = [&](int a, int b) {
+        ++calls;
+        return checked_div(a, b);
+    };
+    auto res2 = invoke_forall_expected(fail_fast, counting_div, 12,
+                                       std::array{3, 0, 4});
+    assert(calls == 2);
+    assert(res2[0].value() == 4);
+    assert(holds<std::domain_error>(res2[1].error()));
+    assert(holds<invoke_skipped>(res2[2].error()));
+
+    // callables returning std::expected are not wrapped again
+    auto res3 = invoke_forall_expected(parse_digit, std::array{'1', 'x', '3'});
+    static_assert(std::is_same_v<
+        decltype(res3), std::array<std::expected<int, std::exception_ptr>, 3>>);
+    assert(res3[0].value() == 1);
+    assert(holds<std::invalid_argument>(res3[1].error()));
+    assert(res3[2].value() == 3);
+
+    auto res4 = invoke_forall_expected(fail_fast, parse_digit,
+                                       std::array{'x', '3'});
+    assert(holds<invoke_skipped>(res4[1].error()));
+
+    // heterogeneous results, lvalue references and void
+    int x = 5;
+    auto res5 = invoke_forall_expected(
+        [&](auto v) -> decltype(auto) {
+            if constexpr (std::is_same_v<decltype(v), int>) {
+                return (x);
+            } else {
+                return std::string(v);
+            }
+        },
+        std::tuple{0, "abc"});
+    std::get<0>(res5).value().get() = 7;
+    assert(x == 7);
+    assert(std::get<1>(res5).value() == "abc");
+
+    auto res6 = invoke_forall_expected([](int) {}, std::array{1, 2});
+    assert(res6[0].has_value() && res6[1].has_value());
+
+    // no Gettable arguments: a single std::expected
+    auto res7 = invoke_forall_expected(checked_div, 1, 0);
+    assert(!res7.has_value());
+
+    // error types that can not hold an exception keep returned errors apart
+    // from thrown and skipped ones
+    using code_error = std::variant<parse_error, std::exception_ptr>;
+    auto res8 = invoke_forall_expected(parse_code,
+                                       std::array{'1', 'x', '!', '3'});
+    static_assert(std::is_same_v<
+        decltype(res8), std::array<std::expected<int, code_error>, 4>>);
+    assert(res8[0].value() == 1);
+    assert(std::get<0>(res8[1].error()) == parse_error::not_a_digit);
+    assert(holds<std::invalid_argument>(std::get<1>(res8[2].error())));
+    assert(res8[3].value() == 3);
+
+    auto res9 = invoke_forall_expected(fail_fast, parse_code,
+                                       std::array{'x', '3'});
+    assert(std::get<0>(res9[0].error()) == parse_error::not_a_digit);
+    assert(holds<invoke_skipped>(std::get<1>(res9[1].error())));
+}
@@ -0,0 +1,179 @@
+#include "invoke_forall_file.h"
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+struct record {
+    std::int32_t id;
+    float value;
+};
+
+namespace fs = std::filesystem;
+
+fs::path temp_file(const std::string& name)
+{
+    return fs::temp_directory_path() /
+           ("invoke_forall_file_" + std::to_string(getpid()) + "_" + name);
+}
+
+fs::path write_records(const std::string& name, std::size_t count)
+{
+    fs::path file = temp_file(name);
+    std::ofstream out(file, std::ios::binary);
+    for (std::size_t i = 0; i < count; ++i) {
+        record r{ static_cast<std::int32_t>(i), 0.5f * static_cast<float>(i) };
+        out.write(reinterpret_cast<const char *>(&r), sizeof(r));
+    }
+    return file;
+}
+
+// collects all results and the size of every chunk
+struct collecting_sink {
+    std::vector<double> *results;
+    std::vector<std::size_t> *chunks;
+
+    void operator()(std::span<const double> values) const
+    {
+        results->insert(results->end(), values.begin(), values.end());
+        chunks->push_back(values.size());
+    }
+};
+
+void test_streaming(file_input input) {
+    // 4 full chunks of 64 and a tail of 13
+    constexpr std::size_t count = 4 * 64 + 13;
+    fs::path file = write_records("in", count);
+
+    std::vector<double> results;
+    std::vector<std::size_t> chunks;
+    double scale = 2.0;
+
+    file_stream_stats stats = invoke_forall_file<record, 64>(
+        { .input = input }, file, collecting_sink{ &results, &chunks },
+        [](double s, const record& r) { return s * r.id + r.value; }, scale);
+
+    assert(stats.records == count);
+    assert(stats.chunks == 5);
+    assert((chunks == std::vector<std::size_t>{64, 64, 64, 64, 13}));
+    assert(results.size() == count);
+    for (std::size_t i = 0; i < count; ++i) {
+        assert(results[i] == 2.0 * double(i) + 0.5 * double(i));
+    }
+
+    fs::remove(file);
+}
+
+void test_file_sink() {
+    constexpr std::size_t count = 1000;
+    fs::path in = write_records("sink_in", count);
+    fs::path out = temp_file("sink_out");
+
+    auto stats = invoke_forall_file<record, 128>(
+        in, file_sink(out), [](const record& r) { return r.id * 3; });
+    assert(stats.records == count);
+    assert(fs::file_size(out) == count * sizeof(int));
+
+    std::ifstream results(out, std::ios::binary);
+    for (std::size_t i = 0; i < count; ++i) {
+        int v = 0;
+        results.read(reinterpret_cast<char *>(&v), sizeof(v));
+        assert(v == 3 * static_cast<int>(i));
+    }
+
+    fs::remove(in);
+    fs::remove(out);
+}
+
+void test_empty() {
+    fs::path file = write_records("empty", 0);
+    std::vector<double> results;
+    std::vector<std::size_t> chunks;
+
+    for (file_input input : { file_input::mapped, file_input::read }) {
+        auto stats = invoke_forall_file<record, 8>(
+            { .input = input }, file, collecting_sink{ &results, &chunks },
+            [](const record& r) { return double(r.value); });
+        assert(stats.records == 0 && stats.chunks == 0);
+    }
+    assert(results.empty());
+
+    fs::remove(file);
+}
+
+void test_errors() {
+    fs::path file = write_records("errors", 100);
+    auto ignore = [](std::span<const int>) {};
+
+    // an invoke throws
+    bool thrown = false;
+    try {
+        invoke_forall_file<record, 16>(file, ignore, [](const record& r) {
+            if (r.id == 42) {
+                throw std::runtime_error("42");
+            }
+            return r.id;
+        });
+    } catch (const std::runtime_error& e) {
+        thrown = std::string(e.what()) == "42";
+    }
+    assert(thrown);
+
+    // the sink throws
+    thrown = false;
+    try {
+        invoke_forall_file<record, 16>(
+            file,
+            [](std::span<const int> values) {
+                if (values[0] == 32) {
+                    throw std::runtime_error("sink");
+                }
+            },
+            [](const record& r) { return r.id; });
+    } catch (const std::runtime_error& e) {
+        thrown = std::string(e.what()) == "sink";
+    }
+    assert(thrown);
+
+    // a trailing partial record
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::app);
+        out.put('x');
+    }
+    for (file_input input : { file_input::mapped, file_input::read }) {
+        thrown = false;
+        try {
+            invoke_forall_file<record, 16>({ .input = input }, file, ignore,
+                                           [](const record& r) {
+                                               return r.id;
+                                           });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    fs::remove(file);
+
+    thrown = false;
+    try {
+        invoke_forall_file<record, 16>(file, ignore,
+                                       [](const record& r) { return r.id; });
+    } catch (const std::system_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+int main() {
+    test_streaming(file_input::mapped);
+    test_streaming(file_input::read);
+    test_file_sink();
+    test_empty();
+    test_errors();
+}
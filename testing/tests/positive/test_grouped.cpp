@@ -0,0 +1,70 @@
+#include "invoke_forall_grouped.h"
+#include <array>
+#include <cassert>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+constexpr auto same = [](auto x) { return x; };
+
+int main() {
+    // partitioned at compile time, groups in order of first occurrence
+    constexpr auto g =
+        invoke_forall_grouped(same, std::tuple{ 1, 2.5, 3, 'c', 4.5, 5 });
+    using result = std::remove_const_t<decltype(g)>;
+    static_assert(
+        std::is_same_v<result,
+                       grouped_result<int, double, int, char, double, int>>);
+    static_assert(result::group_count == 3);
+    static_assert(std::is_same_v<result::group_type<0>, int>);
+    static_assert(std::is_same_v<result::group_type<2>, char>);
+    static_assert(std::is_same_v<result::groups_type,
+                                 std::tuple<std::array<int, 3>,
+                                            std::array<double, 2>,
+                                            std::array<char, 1>>>);
+
+    // the index maps in both directions
+    static_assert(result::indices<0> == std::array<std::size_t, 3>{ 0, 2, 5 });
+    static_assert(result::indices<1> == std::array<std::size_t, 2>{ 1, 4 });
+    static_assert(result::group_of[4] == 1 && result::position_of[4] == 1);
+    static_assert(result::group_index<char> == 2);
+
+    static_assert(g.group<0>() == std::array{ 1, 3, 5 });
+    static_assert(g.group<double>() == std::array{ 2.5, 4.5 });
+    static_assert(g.at<3>() == 'c' && g.at<4>() == 4.5);
+
+    // a homogeneous loop per type
+    auto h = invoke_forall_grouped(std::multiplies<>{},
+                                   std::tuple{ 1, 2.0, 3, 4.0 }, 10);
+    int int_sum = 0;
+    for (int x : h.group<int>()) {
+        int_sum += x;
+    }
+    assert(int_sum == 40);
+    for (std::size_t k = 0; k < h.group<double>().size(); ++k) {
+        assert(h.group<double>()[k] ==
+               10.0 * double(h.indices<1>[k] + 1));
+    }
+
+    // invokes run in index order, non-trivial and reference results
+    std::string log;
+    std::string a = "a";
+    auto r = invoke_forall_grouped(
+        [&](auto& x) -> auto& {
+            log += std::to_string(sizeof(x));
+            return x;
+        },
+        std::tie(a, int_sum, a));
+    assert(log == std::to_string(sizeof(a)) + "4" + std::to_string(sizeof(a)));
+    static_assert(std::is_same_v<decltype(r.group<0>()),
+                                 std::array<std::reference_wrapper<std::string>,
+                                            2>&>);
+    r.at<2>().get() += "b";
+    assert(a == "ab" && &r.at<1>().get() == &int_sum);
+
+    auto moved = invoke_forall_grouped(
+        [](int n) { return std::string(std::size_t(n), 'x'); },
+        std::array{ 20, 30 });
+    assert(moved.group<0>()[1].size() == 30);
+}
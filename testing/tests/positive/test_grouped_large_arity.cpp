@@ -0,0 +1,59 @@
+#include "invoke_forall_grouped.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+// Gettable whose elements alternate between int and double
+template <std::size_t N>
+struct alternating {
+    template <std::size_t I>
+    constexpr auto get() const
+    {
+        if constexpr (I % 2 == 0) {
+            return int(I);
+        } else {
+            return double(I);
+        }
+    }
+};
+
+template <std::size_t N>
+struct std::tuple_size<alternating<N>>
+    : std::integral_constant<std::size_t, N> {};
+
+template <std::size_t I, std::size_t N>
+struct std::tuple_element<I, alternating<N>> {
+    using type = decltype(alternating<N>{}.template get<I>());
+};
+
+int main() {
+    constexpr std::size_t N = 512;
+
+    // a single type is written straight into its group
+    constexpr auto same = [] {
+        std::array<int, N> a{};
+        for (std::size_t i = 0; i < N; ++i) {
+            a[i] = static_cast<int>(i);
+        }
+        return invoke_forall_grouped([](int x) { return x * 2; }, a);
+    }();
+    using same_type = std::remove_const_t<decltype(same)>;
+    static_assert(same_type::group_count == 1);
+    static_assert(same_type::position_of[N - 1] == N - 1);
+    static_assert(same.group<0>()[N - 1] == 2 * (N - 1));
+    static_assert(same.at<100>() == 200);
+
+    // two types, every other result in each group
+    constexpr std::size_t M = 128;
+    auto mixed = invoke_forall_grouped([](auto x) { return x + 1; },
+                                       alternating<M>{});
+    using mixed_type = decltype(mixed);
+    static_assert(mixed_type::group_count == 2);
+    static_assert(mixed_type::group_index<double> == 1);
+    static_assert(mixed_type::indices<1>[3] == 7);
+    assert(mixed.group<int>().size() == M / 2);
+    assert(mixed.group<double>()[3] == 8.0);
+    assert(mixed.at<M - 2>() == int(M - 1));
+}
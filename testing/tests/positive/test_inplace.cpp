@@ -0,0 +1,98 @@
+#include "invoke_forall_inplace.h"
+#include <array>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <string>
+#include <tuple>
+
+constexpr auto square = [](int x) { return x * x; };
+
+// the written array can be used in constant expressions
+constexpr std::array<int, 4> squares = [] {
+    std::array<int, 4> a{1, 2, 3, 4};
+    invoke_forall_inplace(square, a);
+    return a;
+}();
+static_assert(squares == std::array{1, 4, 9, 16});
+
+// other arguments are zipped as in invoke_forall
+constexpr std::array<int, 3> sums = [] {
+    std::array<int, 3> a{1, 2, 3};
+    invoke_forall_inplace(std::plus<int>{}, a, std::array{10, 20, 30});
+    invoke_forall_inplace([](int x, int k) { return x * k; }, a, 2);
+    return a;
+}();
+static_assert(sums == std::array{22, 44, 66});
+
+// another object of the type of the target may be passed whole
+constexpr std::array<int, 3> shifted = [] {
+    std::array<int, 3> a{1, 2, 3};
+    const std::array<int, 3> b{10, 20, 30};
+    invoke_forall_inplace([](int x, const std::array<int, 3>& all) {
+        return x + all[0];
+    }, a, protect_arg(b));
+    return a;
+}();
+static_assert(shifted == std::array{11, 12, 13});
+
+template <typename T>
+concept writable = requires(T& t) { invoke_forall_inplace(square, t); };
+
+static_assert(writable<std::array<int, 2>>);
+static_assert(!writable<const std::array<int, 2>>);
+static_assert(!writable<int>);
+
+int main() {
+    // heterogeneous targets, each result converted to its element
+    std::tuple<int, double, std::string> t{1, 2.5, "ab"};
+    invoke_forall_inplace([](auto x) { return x + x; }, t);
+    assert(t == std::make_tuple(2, 5.0, std::string("abab")));
+
+    // the target may also be passed as another Gettable argument: every
+    // invoke reads its own elements before they are overwritten
+    std::array<int, 4> a{1, 2, 3, 4};
+    invoke_forall_inplace(std::multiplies<int>{}, a, a);
+    assert((a == std::array{1, 4, 9, 16}));
+
+    // results are written as soon as their invoke returns
+    std::array<int, 3> order{0, 0, 0};
+    int calls = 0;
+    invoke_forall_inplace([&](int) { return ++calls; }, order);
+    assert((order == std::array{1, 2, 3}));
+
+    // a Gettable callable
+    std::array<int, 2> b{3, 4};
+    invoke_forall_inplace(std::tuple{square, [](int x) { return -x; }}, b);
+    assert((b == std::array{9, -4}));
+
+    // the target itself passed whole throws before any invoke
+    auto first = [](int x, const std::array<int, 2>& all) {
+        return x + all[0];
+    };
+    auto throws = [&](auto&& arg) {
+        try {
+            invoke_forall_inplace(first, b, arg);
+        } catch (const inplace_target_aliased&) {
+            return true;
+        }
+        return false;
+    };
+    assert(throws(protect_arg(b)));
+    assert(throws(std::cref(b)));
+    assert((b == std::array{9, -4}));
+
+    std::array<int, 2> other{1, 2};
+    auto pointer = [](int x, const std::array<int, 2> *all) {
+        return x + (*all)[1];
+    };
+    invoke_forall_inplace(pointer, b, &other);
+    assert((b == std::array{11, -2}));
+    bool aliased = false;
+    try {
+        invoke_forall_inplace(pointer, b, &b);
+    } catch (const std::exception&) {
+        aliased = true;
+    }
+    assert(aliased);
+}
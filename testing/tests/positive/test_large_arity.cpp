@@ -0,0 +1,29 @@
+#include "invoke_forall.h"
+#include <array>
+#include <functional>
+#include <utility>
+
+int main() {
+    constexpr std::size_t N = 1000;
+
+    static_assert(detail::Gettable<std::array<int, N>>);
+    static_assert(detail::Gettable<const std::array<int, N>&>);
+    static_assert(detail::Gettable<std::pair<int, double>&&>);
+    static_assert(!detail::Gettable<decltype(protect_arg(std::array<int, N>{}))>);
+
+    static_assert(detail::first_arity_or_zero<int, std::array<int, N>&>() == N);
+    static_assert(detail::first_arity_or_zero<int, double>() == 0);
+    static_assert(detail::SameArity<std::array<int, N>, int, std::array<long, N>>);
+    static_assert(!detail::SameArity<std::array<int, N>, std::array<int, N - 1>>);
+
+    constexpr auto res = [] {
+        std::array<int, N> a{};
+        for (std::size_t i = 0; i < N; ++i) {
+            a[i] = static_cast<int>(i);
+        }
+        return invoke_forall(std::plus<int>{}, a, a);
+    }();
+
+    static_assert(std::get<0>(res) == 0);
+    static_assert(std::get<N - 1>(res) == 2 * (N - 1));
+}
@@ -0,0 +1,126 @@
+#include "invoke_forall_memo.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+std::atomic<int> calls = 0;
+
+int square(int x) {
+    ++calls;
+    return x * x;
+}
+
+void test_hits_and_misses() {
+    calls = 0;
+    auto f = memoize_arg(square);
+
+    auto res1 = invoke_forall(f, std::array{1, 2, 1, 2});
+    assert((res1 == std::array{1, 4, 1, 4}));
+    assert(calls == 2);
+    assert(f.stats().hits == 2);
+    assert(f.stats().misses == 2);
+
+    auto res2 = invoke_forall(f, std::array{2, 1});
+    assert((res2 == std::array{4, 1}));
+    assert(calls == 2);
+    assert(f.stats().hits == 4);
+}
+
+void test_rvalue_copies_share_cache() {
+    calls = 0;
+    auto res = invoke_forall(memoize_arg(square), std::array{3, 3, 3});
+    assert((res == std::array{9, 9, 9}));
+    assert(calls == 1);
+}
+
+void test_heterogeneous() {
+    auto f = memoize_arg([](auto a, int b) { return a * b; });
+    auto res = invoke_forall(f, std::tuple{1, 1.5, 1}, 2);
+    assert(std::get<0>(res) == 2);
+    assert(std::get<1>(res) == 3.0);
+    assert(std::get<2>(res) == 2);
+    assert(f.stats().hits == 1);
+}
+
+void test_eviction(eviction_policy policy) {
+    calls = 0;
+    auto f = memoize_arg(square, { .capacity = 2, .eviction = policy,
+                                   .shards = 1 });
+
+    invoke_forall(f, std::array{1, 2, 3});
+    assert(calls == 3);
+    assert(f.stats().evictions == 1);
+    assert(f(3) == 9);
+    assert(calls == 3);
+    assert(f(1) == 1);
+    assert(calls == 4);
+}
+
+void test_lru_order() {
+    calls = 0;
+    auto f = memoize_arg(square, { .capacity = 2,
+                                   .eviction = eviction_policy::lru,
+                                   .shards = 1 });
+
+    invoke_forall(f, std::array{1, 2, 1, 3});
+    assert(calls == 3);
+    f(1);
+    assert(calls == 3);
+    f(2);
+    assert(calls == 4);
+}
+
+void test_exact_capacity() {
+    // every miss of a full cache evicts, so the number of kept entries is
+    // misses - evictions
+    for (std::size_t capacity : {10, 3, 1}) {
+        auto f = memoize_arg(square, { .capacity = capacity, .shards = 4 });
+        for (int i = 0; i < 1000; ++i) {
+            f(i);
+        }
+        assert(f.stats().misses == 1000);
+        assert(f.stats().evictions == 1000 - capacity);
+    }
+
+    calls = 0;
+    auto none = memoize_arg(square, { .capacity = 0 });
+    none(2);
+    assert(none(2) == 4);
+    assert(calls == 2 && none.stats().hits == 0);
+}
+
+void test_concurrent() {
+    calls = 0;
+    auto f = memoize_arg(square, { .capacity = 64 });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([f] {
+            for (int i = 0; i < 1000; ++i) {
+                auto res = invoke_forall(f, std::array{i % 16, (i + 1) % 16});
+                assert(res[0] == (i % 16) * (i % 16));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto stats = f.stats();
+    assert(stats.hits + stats.misses == 8000);
+    assert(stats.misses < 100);
+}
+
+int main() {
+    test_hits_and_misses();
+    test_rvalue_copies_share_cache();
+    test_heterogeneous();
+    test_eviction(eviction_policy::lru);
+    test_eviction(eviction_policy::clock);
+    test_lru_order();
+    test_exact_capacity();
+    test_concurrent();
+}
@@ -0,0 +1,78 @@
+#include "invoke_forall_nd.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <tuple>
+#include <variant>
+
+template <std::size_t R, std::size_t C>
+using matrix = std::array<std::array<float, C>, R>;
+
+constexpr matrix<2, 3> m1{{{1, 2, 3}, {4, 5, 6}}};
+constexpr matrix<2, 3> m2{{{10, 20, 30}, {40, 50, 60}}};
+
+int main() {
+    // element-wise 2-D kernel at compile time, with a broadcast scalar
+    constexpr auto sum = invoke_forall_nd(
+        [](float a, float b, float k) { return a + b * k; }, m1, m2, 2.0f);
+    static_assert(std::is_same_v<decltype(sum), const matrix<2, 3>>);
+    static_assert(sum[1][2] == 126.0f);
+    static_assert(sum[0][0] == 21.0f);
+
+    // every order gives the same result
+    matrix<37, 53> big_a{};
+    matrix<37, 53> big_b{};
+    for (std::size_t r = 0; r < 37; ++r) {
+        for (std::size_t c = 0; c < 53; ++c) {
+            big_a[r][c] = float(r * 53 + c);
+            big_b[r][c] = float(c);
+        }
+    }
+    auto tiled = invoke_forall_nd(std::minus<float>{}, big_a, big_b);
+    auto small_tiles = invoke_forall_nd(
+        nd_options{ .order = nd_order::tiled, .tile = 5 }, std::minus<float>{},
+        big_a, big_b);
+    auto row = invoke_forall_nd({ .order = nd_order::row_major },
+                                std::minus<float>{}, big_a, big_b);
+    auto col = invoke_forall_nd({ .order = nd_order::column_major },
+                                std::minus<float>{}, big_a, big_b);
+    assert(tiled == row && small_tiles == row && col == row);
+    assert(row[36][52] == float(36 * 53));
+
+    // visiting order
+    std::array<std::array<int, 2>, 2> ids{};
+    int next = 0;
+    auto order = invoke_forall_nd({ .order = nd_order::column_major },
+                                  [&](int) { return next++; }, ids);
+    assert(order[0][0] == 0 && order[1][0] == 1);
+    assert(order[0][1] == 2 && order[1][1] == 3);
+
+    // 3-D
+    std::array<std::array<std::array<int, 4>, 3>, 2> cube{};
+    cube[1][2][3] = 5;
+    auto doubled = invoke_forall_nd([](int x) { return x * 2; }, cube);
+    assert(doubled[1][2][3] == 10);
+
+    // an explicit rank passes the rows whole
+    auto row_sums = invoke_forall_nd<1>(
+        [](const std::array<float, 3>& r) { return r[0] + r[1] + r[2]; }, m1);
+    static_assert(std::is_same_v<decltype(row_sums), std::array<float, 2>>);
+    assert(row_sums[1] == 15.0f);
+
+    // protected arguments are unwrapped and passed to every invoke
+    std::tuple<float, float> range{0.0f, 10.0f};
+    auto clamped = invoke_forall_nd(
+        [](float x, const std::tuple<float, float>& r) {
+            return std::clamp(x, std::get<0>(r), std::get<1>(r));
+        },
+        m2, protect_arg(range));
+    assert(clamped[0][0] == 10.0f && clamped[1][2] == 10.0f);
+
+    // void results are stored as std::monostate
+    int visited = 0;
+    auto none = invoke_forall_nd([&](float) { ++visited; }, m1);
+    static_assert(std::is_same_v<
+        decltype(none), std::array<std::array<std::monostate, 3>, 2>>);
+    assert(visited == 6);
+}
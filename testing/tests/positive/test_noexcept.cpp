@@ -0,0 +1,102 @@
+#include "invoke_forall.h"
+#include <array>
+#include <cassert>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+int add(int a, int b) noexcept { return a + b; }
+int add_throwing(int a, int b) { return a + b; }
+
+struct throwing_copy {
+    throwing_copy() = default;
+    throwing_copy(const throwing_copy&) noexcept(false) {}
+    throwing_copy(throwing_copy&&) noexcept = default;
+    int operator()(int x) const noexcept { return x; }
+};
+
+struct throwing_move {
+    throwing_move() = default;
+    throwing_move(const throwing_move&) noexcept(false) {}
+    throwing_move(throwing_move&&) noexcept(false) {}
+};
+
+struct noexcept_hooks {
+    template <std::size_t I, typename... Ts>
+    void enter() noexcept {}
+    template <std::size_t I, typename... Ts>
+    void exit() noexcept {}
+};
+
+struct throwing_hooks {
+    template <std::size_t I, typename... Ts>
+    void enter() {}
+    template <std::size_t I, typename... Ts>
+    void exit() noexcept {}
+};
+
+using ints = std::tuple<int, int, int>;
+
+// the callable decides
+static_assert(is_nothrow_invoke_forall_v<decltype(&add), ints, int>);
+static_assert(!is_nothrow_invoke_forall_v<decltype(&add_throwing), ints, int>);
+static_assert(is_nothrow_invoke_forall_v<decltype(&add), int, int>);
+
+// an rvalue callable used by several invokes is copied for all but the last
+static_assert(is_nothrow_invoke_forall_v<throwing_copy&, ints>);
+static_assert(!is_nothrow_invoke_forall_v<throwing_copy, ints>);
+static_assert(is_nothrow_invoke_forall_v<throwing_copy, int>);
+
+// results stored in a tuple are moved, results in an array are not
+constexpr auto make = [](auto) noexcept { return throwing_move{}; };
+constexpr auto make_mixed = [](auto x) noexcept {
+    if constexpr (std::is_same_v<decltype(x), int>) {
+        return throwing_move{};
+    } else {
+        return 0;
+    }
+};
+static_assert(is_nothrow_invoke_forall_v<decltype(make), ints>);
+static_assert(
+    !is_nothrow_invoke_forall_v<decltype(make_mixed), std::tuple<int, long>>);
+
+constexpr auto take = [](throwing_move&& m) noexcept -> throwing_move&& {
+    return std::move(m);
+};
+static_assert(!is_nothrow_invoke_forall_v<
+              decltype(take), std::tuple<throwing_move, throwing_move>>);
+
+// the detail chain propagates, including the hooks
+static_assert(noexcept(detail::try_get<0>(std::declval<ints&>())));
+static_assert(noexcept(detail::forward_copy_rvalue<2, 1>(1)));
+static_assert(!noexcept(
+    detail::forward_copy_rvalue<2, 0>(std::declval<throwing_copy>())));
+static_assert(noexcept(detail::invoke_at<1>(&add, std::declval<ints&>(), 1)));
+static_assert(noexcept(detail::invoke_forall_hooked(
+    std::declval<noexcept_hooks&>(), &add, std::declval<ints&>(), 1)));
+static_assert(!noexcept(detail::invoke_forall_hooked(
+    std::declval<throwing_hooks&>(), &add, std::declval<ints&>(), 1)));
+
+// trivially copyable results
+static_assert(is_trivially_copyable_invoke_forall_v<decltype(&add), ints, int>);
+static_assert(!is_trivially_copyable_invoke_forall_v<
+              std::string (*)(int), std::array<int, 2>>);
+static_assert(std::is_same_v<invoke_forall_result_t<decltype(&add), ints, int>,
+                             std::array<int, 3>>);
+
+int main() {
+    // containers move results that cannot throw instead of copying them
+    std::vector<std::array<std::string, 2>> rows;
+    auto row = [](int i) noexcept { return std::to_string(i); };
+    static_assert(noexcept(invoke_forall(row, std::array{ 1, 2 })));
+    for (int i = 0; i < 10; ++i) {
+        rows.push_back(invoke_forall(row, std::array{ i, i + 1 }));
+    }
+    assert(rows[9][1] == "10");
+
+    ints t{ 1, 2, 3 };
+    static_assert(noexcept(invoke_forall(add, t, 10)));
+    assert(invoke_forall(add, t, 10)[2] == 13);
+}
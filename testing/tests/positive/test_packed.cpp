@@ -0,0 +1,63 @@
+#include "invoke_forall_packed.h"
+#include <array>
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+
+template <std::size_t N>
+constexpr std::array<int, N> iota()
+{
+    std::array<int, N> values{};
+    for (std::size_t i = 0; i < N; ++i) {
+        values[i] = int(i);
+    }
+    return values;
+}
+
+constexpr auto values = iota<512>();
+constexpr auto even = [](int x) { return x % 2 == 0; };
+constexpr auto below = [](int x, int limit) { return x < limit; };
+
+// 512 bools in 64 bytes
+static_assert(sizeof(packed_bools<512>) == 64);
+static_assert(sizeof(packed_bools<65>) == 16);
+static_assert(std::tuple_size_v<packed_bools<512>> == 512);
+static_assert(detail::Gettable<packed_bools<3>>);
+
+// usable in constant expressions
+constexpr auto evens = invoke_forall_packed(even, values);
+static_assert(std::is_same_v<decltype(evens), const packed_bools<512>>);
+static_assert(evens.count() == 256);
+static_assert(get<0>(evens) && !evens.get<511>());
+static_assert(evens.words()[0] == 0x5555555555555555);
+
+constexpr auto small = invoke_forall_packed(below, values, 100);
+static_assert((evens & small).count() == 50);
+static_assert((evens | small).count() == 256 + 50);
+static_assert((evens ^ small).count() == 256);
+static_assert((~evens).count() == 256 && (~evens & evens).none());
+static_assert(invoke_forall_packed(below, values, 512).all());
+static_assert(!small.all() && small.any());
+
+int main() {
+    // a partial last word, set and cleared bits
+    auto odd = invoke_forall_packed([](int x) { return x % 2 == 1; },
+                                    std::tuple{ 1, 3, 4 });
+    static_assert(std::is_same_v<decltype(odd), packed_bools<3>>);
+    assert(odd[0] && odd[1] && !odd[2] && odd.count() == 2);
+    assert((~odd).count() == 1 && (~odd)[2]);
+    odd.set(2);
+    assert(odd.all());
+    odd.set(0, false);
+    assert(!odd.all() && odd.words()[0] == 0b110);
+
+    // fed back into invoke_forall
+    auto back = invoke_forall([](bool b, int x) { return b ? x : -x; }, odd,
+                              std::array{ 1, 2, 3 });
+    assert((back == std::array{ -1, 2, 3 }));
+
+    packed_bools<130> all_set = ~packed_bools<130>{};
+    assert(all_set.all() && all_set.count() == 130);
+    all_set ^= all_set;
+    assert(all_set.none());
+}
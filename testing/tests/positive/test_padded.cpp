@@ -0,0 +1,46 @@
+#include "invoke_forall_parallel.h"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+int main() {
+    std::array<int, 8> a{1, 2, 3, 4, 5, 6, 7, 8};
+
+    auto padded_res = invoke_forall_padded(parallel, std::plus<int>{}, a, 10);
+    static_assert(decltype(padded_res)::size() == 8);
+    static_assert(alignof(padded<int>) >= 32);
+    for (std::size_t i = 0; i < 8; ++i) {
+        assert(padded_res[i] == a[i] + 10);
+        auto addr = reinterpret_cast<std::uintptr_t>(&padded_res[i]);
+        assert(addr % alignof(padded<int>) == 0);
+    }
+
+    std::array<int, 8> compact = padded_res.compact();
+    assert(compact == invoke_forall(std::plus<int>{}, a, 10));
+
+    auto grained = invoke_forall_padded(parallel_policy{ nullptr, 3 },
+                                        [](int x) { return x * x; }, a);
+    assert(grained[7] == 64);
+
+    auto strings = invoke_forall_padded(sequenced,
+                                        [](int x) { return std::to_string(x); },
+                                        std::tuple{1, 2, 3});
+    std::array<std::string, 3> moved = std::move(strings).compact();
+    assert(moved[2] == "3");
+
+    bool thrown = false;
+    try {
+        invoke_forall_padded(parallel, [](int x) {
+            if (x == 5) {
+                throw std::runtime_error("5");
+            }
+            return x;
+        }, a);
+    } catch (const std::runtime_error& e) {
+        thrown = std::string(e.what()) == "5";
+    }
+    assert(thrown);
+}
@@ -0,0 +1,89 @@
+#include "invoke_forall_parallel.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+void test_same_results() {
+    std::array<int, 8> a{1, 2, 3, 4, 5, 6, 7, 8};
+
+    auto seq = invoke_forall(std::plus<int>{}, a, 10);
+    auto par = invoke_forall(parallel, std::plus<int>{}, a, 10);
+    auto seq_policy = invoke_forall(sequenced, std::plus<int>{}, a, 10);
+    static_assert(std::is_same_v<decltype(seq), decltype(par)>);
+    assert(seq == par);
+    assert(seq == seq_policy);
+
+    auto het = invoke_forall(parallel, [](auto x) { return x + x; },
+                             std::tuple{1, 2.5, std::string("ab")});
+    static_assert(std::is_same_v<decltype(het),
+                                 std::tuple<int, double, std::string>>);
+    assert(std::get<0>(het) == 2);
+    assert(std::get<1>(het) == 5.0);
+    assert(std::get<2>(het) == "abab");
+
+    auto refs = invoke_forall(parallel, [](int& x) -> int& { return x; }, a);
+    refs[3].get() = 40;
+    assert(a[3] == 40);
+
+    assert(invoke_forall(parallel, std::plus<int>{}, 2, 3) == 5);
+}
+
+void test_exceptions() {
+    bool thrown = false;
+    try {
+        invoke_forall(parallel, [](int x) {
+            if (x % 2 == 0) {
+                throw std::runtime_error(std::to_string(x));
+            }
+            return x;
+        }, std::array{1, 2, 3, 4});
+    } catch (const std::runtime_error& e) {
+        thrown = true;
+        assert(std::string(e.what()) == "2");
+    }
+    assert(thrown);
+}
+
+void test_streaming() {
+    thread_pool pool(2);
+    std::atomic<bool> first_consumed = false;
+
+    auto stream = invoke_forall_async(
+        parallel_policy{ &pool },
+        [&](int x) {
+            if (x == 1) {
+                first_consumed.wait(false);
+            }
+            return x * 10;
+        },
+        std::array{0, 1});
+
+    // the first result is available while the second invoke still waits
+    assert(stream->get<0>() == 0);
+    assert(!stream->ready(1));
+    assert(stream->try_get<1>() == nullptr);
+    first_consumed = true;
+    first_consumed.notify_all();
+
+    assert((*stream)[1] == 10);
+    assert(*stream->try_get<1>() == 10);
+}
+
+void test_rvalue_arguments() {
+    auto res = invoke_forall(
+        parallel,
+        [](std::string s, const std::string& suffix) { return s + suffix; },
+        std::array{std::string("a"), std::string("b"), std::string("c")},
+        std::string("!"));
+    assert(res[0] == "a!" && res[1] == "b!" && res[2] == "c!");
+}
+
+int main() {
+    test_same_results();
+    test_exceptions();
+    test_streaming();
+    test_rvalue_arguments();
+}
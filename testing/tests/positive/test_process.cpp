@@ -0,0 +1,129 @@
+#include "invoke_forall_process.h"
+#include <array>
+#include <cassert>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+
+int global_counter = 0;
+
+int legacy(int x) {
+    // not thread-safe, but every worker has its own copy
+    global_counter += x;
+    return x * 10;
+}
+
+int rethrow_message(const std::exception_ptr& error, bool& crashed,
+                    int& signal, std::string& what) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const process_invoke_error& e) {
+        crashed = e.crashed();
+        signal = e.signal();
+        what = e.what();
+        return 1;
+    }
+    return 0;
+}
+
+int exit_status_of(const std::exception_ptr& error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const process_invoke_error& e) {
+        return e.exit_status();
+    }
+    return -2;
+}
+
+int main() {
+    std::array<int, 6> a{1, 2, 3, 4, 5, 6};
+
+    auto res = invoke_forall_expected(process_policy{ 3 }, legacy, a);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        assert(res[i].has_value());
+        assert(*res[i] == a[i] * 10);
+    }
+    // invokes ran in other processes
+    assert(global_counter == 0);
+
+    auto crashing = invoke_forall_expected(isolated, [](int x) {
+        if (x == 2) {
+            std::raise(SIGSEGV);
+        }
+        if (x == 4) {
+            throw std::runtime_error("four");
+        }
+        if (x == 5) {
+            std::_Exit(3);
+        }
+        return getpid();
+    }, a);
+
+    bool crashed = false;
+    int signal = 0;
+    std::string what;
+
+    assert(crashing[0].has_value() && *crashing[0] != getpid());
+    assert(!crashing[1].has_value());
+    rethrow_message(crashing[1].error(), crashed, signal, what);
+    assert(crashed && signal == SIGSEGV);
+
+    assert(!crashing[3].has_value());
+    rethrow_message(crashing[3].error(), crashed, signal, what);
+    assert(!crashed && what == "four");
+
+    assert(!crashing[4].has_value());
+    rethrow_message(crashing[4].error(), crashed, signal, what);
+    assert(crashed && signal == 0);
+    assert(what == "worker exited with status 3 before writing the result");
+    assert(exit_status_of(crashing[4].error()) == 3);
+    assert(exit_status_of(crashing[1].error()) == -1);
+
+    assert(crashing[2].has_value() && crashing[5].has_value());
+
+    // exiting with status 0 is not mistaken for a finished worker
+    auto exiting = invoke_forall_expected(process_policy{ 1 }, [](int x) {
+        if (x == 2) {
+            std::exit(0);
+        }
+        if (x == 4) {
+            _exit(0);
+        }
+        return x;
+    }, a);
+    for (std::size_t i : {1, 3}) {
+        assert(!exiting[i].has_value());
+        rethrow_message(exiting[i].error(), crashed, signal, what);
+        assert(crashed && signal == 0);
+        assert(what == "worker exited with status 0 before writing the result");
+        assert(exit_status_of(exiting[i].error()) == 0);
+    }
+    assert(*exiting[0] == 1 && *exiting[2] == 3 && *exiting[5] == 6);
+
+    auto het = invoke_forall_expected(process_policy{ 2 },
+                                      [](auto x) { return x * 2; },
+                                      std::tuple{1, 2.5, 'a'});
+    static_assert(std::is_same_v<
+        decltype(het),
+        std::tuple<std::expected<int, std::exception_ptr>,
+                   std::expected<double, std::exception_ptr>,
+                   std::expected<int, std::exception_ptr>>>);
+    assert(*std::get<1>(het) == 5.0);
+    assert(*std::get<2>(het) == 'a' * 2);
+
+    // no Gettable arguments: a single std::expected, as without a policy
+    auto single = invoke_forall_expected(isolated, std::plus<int>{}, 2, 3);
+    static_assert(std::is_same_v<
+        decltype(single), std::expected<int, std::exception_ptr>>);
+    assert(*single == 5);
+
+    auto failed = invoke_forall_expected(isolated, [](int) -> int {
+        throw std::runtime_error("single");
+    }, 1);
+    assert(!failed.has_value());
+    rethrow_message(failed.error(), crashed, signal, what);
+    assert(!crashed && what == "single");
+}
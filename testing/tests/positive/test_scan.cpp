@@ -0,0 +1,109 @@
+#include "invoke_forall_parallel.h"
+#include "invoke_forall_scan.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <string>
+#include <tuple>
+
+constexpr auto max_op = [](int a, int b) { return std::max(a, b); };
+
+void test_compile_time() {
+    constexpr std::array<int, 5> a{3, 1, 4, 1, 5};
+
+    constexpr auto sums = invoke_forall_scan(std::plus<>{},
+                                             [](int x) { return x; }, a);
+    static_assert(sums.inclusive == std::array{3, 4, 8, 9, 14});
+    static_assert(sums.exclusive == std::array{0, 3, 4, 8, 9});
+
+    constexpr auto maxima = invoke_forall_scan(max_op, std::negate<int>{}, a);
+    static_assert(maxima.inclusive == std::array{-3, -1, -1, -1, -1});
+
+    // heterogeneous results are combined in their common type
+    constexpr auto costs = invoke_forall_scan(
+        std::plus<>{}, [](auto x) { return x * 2; }, std::tuple{1, 2L, 0.5});
+    static_assert(std::is_same_v<decltype(costs),
+                                 const scan_result<double, 3>>);
+    static_assert(costs.inclusive == std::array{2.0, 6.0, 7.0});
+
+    // non-Gettable arguments perform a single invoke
+    constexpr auto single = invoke_forall_scan(std::plus<>{},
+                                               std::plus<int>{}, 2, 3);
+    static_assert(single.inclusive == std::array{5});
+    static_assert(single.exclusive == std::array{0});
+
+    // an initial value that is the identity of the operation
+    constexpr auto products = invoke_forall_scan(
+        std::multiplies<>{}, scan_init(1), [](int x) { return x; }, a);
+    static_assert(products.inclusive == std::array{3, 3, 12, 12, 60});
+    static_assert(products.exclusive == std::array{1, 3, 3, 12, 12});
+
+    constexpr auto lowest = invoke_forall_scan(max_op, scan_init(-100),
+                                               std::negate<int>{}, a);
+    static_assert(lowest.exclusive == std::array{-100, -3, -1, -1, -1});
+    static_assert(lowest.inclusive == maxima.inclusive);
+
+    // the initial value takes part in the common type
+    constexpr auto widened = invoke_forall_scan(std::plus<>{}, scan_init(0.5),
+                                                [](int x) { return x; }, a);
+    static_assert(widened.inclusive == std::array{3.5, 4.5, 8.5, 9.5, 14.5});
+}
+
+void test_parallel() {
+    std::array<int, 37> a{};
+    for (int i = 0; i < 37; ++i) {
+        a[i] = i * 7 % 11;
+    }
+    auto square = [](int x) { return x * x; };
+
+    auto seq = invoke_forall_scan(std::plus<>{}, square, a);
+
+    thread_pool pool(4);
+    auto par = invoke_forall_scan(parallel_policy{ &pool }, std::plus<>{},
+                                  square, a);
+    assert(par.inclusive == seq.inclusive);
+    assert(par.exclusive == seq.exclusive);
+
+    auto seq_max = invoke_forall_scan(max_op, square, a);
+    auto par_max = invoke_forall_scan(parallel, max_op, square, a);
+    assert(par_max.inclusive == seq_max.inclusive);
+    assert(par_max.exclusive == seq_max.exclusive);
+
+    auto seq_policy = invoke_forall_scan(sequenced, std::plus<>{}, square, a);
+    assert(seq_policy.inclusive == seq.inclusive);
+
+    // string concatenation is associative, but not commutative
+    auto words = invoke_forall_scan(parallel_policy{ &pool }, std::plus<>{},
+                                    [](int x) { return std::to_string(x); },
+                                    std::array{1, 2, 3, 4, 5, 6});
+    assert(words.inclusive[5] == "123456");
+    assert(words.exclusive[3] == "123");
+    assert(words.exclusive[0].empty());
+
+    // with an initial value every chunk, the first one included, is offset
+    std::array<int, 37> signs{};
+    for (int i = 0; i < 37; ++i) {
+        signs[i] = i % 5 == 0 ? -1 : 1;
+    }
+    auto seq_prod = invoke_forall_scan(std::multiplies<>{}, scan_init(2),
+                                       std::identity{}, signs);
+    auto par_prod = invoke_forall_scan(parallel_policy{ &pool },
+                                       std::multiplies<>{}, scan_init(2),
+                                       std::identity{}, signs);
+    assert(seq_prod.exclusive[0] == 2 && seq_prod.inclusive[0] == -2);
+    assert(par_prod.inclusive == seq_prod.inclusive);
+    assert(par_prod.exclusive == seq_prod.exclusive);
+
+    auto prefixed = invoke_forall_scan(parallel_policy{ &pool }, std::plus<>{},
+                                       scan_init(std::string(">")),
+                                       [](int x) { return std::to_string(x); },
+                                       std::array{1, 2, 3, 4, 5, 6});
+    assert(prefixed.exclusive[0] == ">");
+    assert(prefixed.inclusive[5] == ">123456");
+}
+
+int main() {
+    test_compile_time();
+    test_parallel();
+}
@@ -0,0 +1,160 @@
+#include "invoke_forall_sender.h"
+#include <array>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+// receiver storing the completion, counting down `done` when it arrives
+template <typename T>
+struct result_receiver {
+    std::optional<T> *value;
+    std::exception_ptr *error;
+    bool *stopped;
+    std::latch *done;
+
+    void set_value(T v) && noexcept
+    {
+        value->emplace(std::move(v));
+        done->count_down();
+    }
+
+    void set_error(std::exception_ptr e) && noexcept
+    {
+        *error = std::move(e);
+        done->count_down();
+    }
+
+    void set_stopped() && noexcept
+    {
+        *stopped = true;
+        done->count_down();
+    }
+};
+
+template <typename T>
+struct completion {
+    std::optional<T> value;
+    std::exception_ptr error;
+    bool stopped = false;
+};
+
+// connects and starts `sender`, then waits for its completion
+template <typename T, typename Sender>
+completion<T> run(Sender&& sender)
+{
+    completion<T> result;
+    std::latch done(1);
+
+    auto op = std::forward<Sender>(sender).connect(result_receiver<T>{
+        &result.value, &result.error, &result.stopped, &done });
+    op.start();
+    done.wait();
+    return result;
+}
+
+// scheduler whose operations always stop
+struct stopping_scheduler {
+    struct sender {
+        template <typename Receiver>
+        struct operation {
+            Receiver receiver;
+
+            void start() & noexcept { std::move(receiver).set_stopped(); }
+        };
+
+        template <typename Receiver>
+        operation<Receiver> connect(Receiver receiver) const
+        {
+            return { std::move(receiver) };
+        }
+    };
+
+    sender schedule() const noexcept { return {}; }
+};
+
+void test_inline() {
+    std::array<int, 4> a{1, 2, 3, 4};
+
+    auto sender = invoke_forall_sender(inline_scheduler{}, std::plus<int>{},
+                                       a, 10);
+    a[0] = 100;  // arguments are copied into the sender
+
+    using value_type = std::array<int, 4>;
+    static_assert(std::is_same_v<decltype(invoke_forall(std::plus<int>{}, a,
+                                                        10)),
+                                 value_type>);
+
+    auto first = run<value_type>(sender);
+    assert(first.value == (value_type{11, 12, 13, 14}));
+
+    // the sender can be connected again
+    auto second = run<value_type>(sender);
+    assert(second.value == first.value);
+
+    auto moved = run<value_type>(std::move(sender));
+    assert(moved.value == first.value);
+}
+
+void test_pool() {
+    thread_pool pool(3);
+    std::array<int, 16> a{};
+    for (int i = 0; i < 16; ++i) {
+        a[i] = i;
+    }
+
+    auto sender = invoke_forall_sender(pool_scheduler{ pool },
+                                       [](int x) { return x * x; }, a);
+    auto result = run<std::array<int, 16>>(sender);
+    assert(result.value == invoke_forall([](int x) { return x * x; }, a));
+
+    // heterogeneous results complete as a tuple
+    auto mixed = run<std::tuple<int, double, std::string>>(
+        invoke_forall_sender(pool_scheduler{ pool },
+                             [](auto x) { return x + x; },
+                             std::tuple{1, 2.5, std::string("ab")}));
+    assert(mixed.value == std::tuple(2, 5.0, std::string("abab")));
+
+    // references through std::ref
+    std::array<int, 3> b{1, 2, 3};
+    auto refs = run<std::array<std::reference_wrapper<int>, 3>>(
+        invoke_forall_sender(pool_scheduler{ pool },
+                             [](int& x) -> int& { return x; }, std::ref(b)));
+    refs.value->at(1).get() = 20;
+    assert(b[1] == 20);
+}
+
+void test_errors() {
+    auto throwing = [](int x) {
+        if (x % 2 == 0) {
+            throw std::runtime_error(std::to_string(x));
+        }
+        return x;
+    };
+
+    thread_pool pool(2);
+    auto result = run<std::array<int, 4>>(invoke_forall_sender(
+        pool_scheduler{ pool }, throwing, std::array{1, 2, 3, 4}));
+    assert(!result.value && result.error);
+
+    try {
+        std::rethrow_exception(result.error);
+    } catch (const std::runtime_error& e) {
+        assert(std::string(e.what()) == "2");
+    }
+
+    auto stopped = run<std::array<int, 2>>(invoke_forall_sender(
+        stopping_scheduler{}, throwing, std::array{1, 3}));
+    assert(stopped.stopped && !stopped.value && !stopped.error);
+}
+
+int main() {
+    test_inline();
+    test_pool();
+    test_errors();
+}
@@ -0,0 +1,105 @@
+// the variants only agree bitwise without floating-point contraction, which
+// Clang enables by default, as does GCC outside of ISO modes
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "invoke_forall_simd.h"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+
+constexpr std::array<simd_isa, 3> variants{ simd_isa::baseline, simd_isa::avx2,
+                                            simd_isa::avx512 };
+
+template <typename T, std::size_t N>
+std::array<T, N> ramp(T start, T step)
+{
+    std::array<T, N> values{};
+    for (std::size_t i = 0; i < N; ++i) {
+        values[i] = start + T(i) * step;
+    }
+    return values;
+}
+
+// runs the kernel with every variant this CPU supports, compares bitwise
+template <typename... Args>
+void check_variants(const Args&...args)
+{
+    auto expected = invoke_forall(args...);
+    assert(invoke_forall_simd(args...) == expected);
+
+    for (simd_isa isa : variants) {
+        if (simd_supported(isa)) {
+            assert(invoke_forall_simd(isa, args...) == expected);
+        } else {
+            bool thrown = false;
+            try {
+                invoke_forall_simd(isa, args...);
+            } catch (const std::invalid_argument&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+}
+
+int main() {
+    // compile time falls back to invoke_forall
+    constexpr std::array<int, 4> small{ 1, 2, 3, 4 };
+    constexpr auto squares =
+        invoke_forall_simd([](int x) { return x * x; }, small);
+    static_assert(squares == std::array<int, 4>{ 1, 4, 9, 16 });
+
+    assert(simd_supported(simd_isa::baseline));
+    assert(simd_supported(simd_detected_isa()));
+
+    // odd sizes leave remainders after the vector loop; the products are
+    // not exact, so rounding them separately from the sums, as the baseline
+    // does, differs from a fused multiply-add
+    auto a = ramp<float, 1027>(0.1f, 0.37f);
+    auto b = ramp<float, 1027>(-3.3f, 0.129f);
+    float k = 1.1f;
+    std::size_t fused_differs = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        fused_differs += std::fma(a[i], k, b[i]) != a[i] * k + b[i];
+    }
+    assert(fused_differs > 0);
+    check_variants([](float x, float y, float k) { return x * k + y; }, a, b,
+                   k);
+    check_variants(std::minus<float>{}, a, b);
+
+    auto c = ramp<double, 61>(1.0, 0.1);
+    fused_differs = 0;
+    for (double x : c) {
+        fused_differs += std::fma(x, x, -1.0) != x * x - 1.0;
+    }
+    assert(fused_differs > 0);
+    check_variants([](double x) { return x * x - 1.0; }, c);
+
+    auto d = ramp<std::int32_t, 333>(-100, 7);
+    auto e = ramp<std::int32_t, 333>(5, -3);
+    check_variants([](std::int32_t x, std::int32_t y) { return x * y ^ y; }, d,
+                   e);
+
+    auto f = ramp<std::uint8_t, 100>(0, 3);
+    check_variants([](std::uint8_t x) { return std::uint8_t(x + 7); }, f);
+
+    // results have the type returned by invoke_forall
+    auto sums = invoke_forall_simd(std::plus<>{}, d, 1.5);
+    static_assert(std::is_same_v<decltype(sums), std::array<double, 333>>);
+    assert(sums[0] == -98.5);
+
+    // anything else is forwarded to invoke_forall
+    auto mixed = invoke_forall_simd([](auto x) { return x; },
+                                    std::tuple{ 1, 2.0 });
+    static_assert(std::is_same_v<decltype(mixed), std::tuple<int, double>>);
+    auto refs = invoke_forall_simd([](int& x) -> int& { return x; }, d);
+    assert(&refs[3].get() == &d[3]);
+}
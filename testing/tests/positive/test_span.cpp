@@ -0,0 +1,77 @@
+#include "invoke_forall_span.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <tuple>
+
+struct point {
+    int x;
+    int y;
+};
+
+// an accessor that opts in to span results
+struct element {
+    template <typename T>
+    constexpr T& operator()(T& x) const noexcept { return x; }
+};
+
+template <>
+struct is_element_accessor<element> : std::true_type {};
+
+constexpr bool test_constexpr() {
+    std::array<int, 3> a{1, 2, 3};
+    auto view = invoke_forall_span(std::identity{}, a);
+    view[1] = 20;
+    return view.data() == a.data() && a[1] == 20;
+}
+
+int main() {
+    static_assert(test_constexpr());
+
+    std::array<int, 5> a{1, 2, 3, 4, 5};
+
+    auto view = invoke_forall_span(std::identity{}, a);
+    static_assert(std::is_same_v<decltype(view), std::span<int, 5>>);
+    assert(view.data() == a.data());
+    view[2] = 30;
+    assert(a[2] == 30);
+
+    const std::array<int, 2> c{1, 2};
+    auto const_view = invoke_forall_span(element{}, c);
+    static_assert(std::is_same_v<decltype(const_view),
+                                 std::span<const int, 2>>);
+    assert(const_view.data() == c.data());
+
+    // other callables may return any reference of the element type, so
+    // they get reference_wrappers
+    auto same = [](int& x) -> int& { return x; };
+    auto refs = invoke_forall_span(same, a);
+    static_assert(std::is_same_v<
+        decltype(refs), std::array<std::reference_wrapper<int>, 5>>);
+    assert(&refs[4].get() == &a[4]);
+
+    std::array<int, 3> table{};
+    auto lookup = invoke_forall_span(
+        [&](int& x) -> int& { return table[x % 3]; }, a);
+    static_assert(std::is_same_v<
+        decltype(lookup), std::array<std::reference_wrapper<int>, 5>>);
+    assert(&lookup[0].get() == &table[1]);
+
+    std::array<std::size_t, 3> idx{2, 0, 1};
+    auto shuffled = invoke_forall_span(
+        [&](std::size_t i) -> int& { return a[i]; }, idx);
+    assert(&shuffled[0].get() == &a[2]);
+
+    std::array<point, 3> points{};
+    auto xs = invoke_forall_span([](point& p) -> int& { return p.x; }, points);
+    static_assert(std::is_same_v<
+        decltype(xs), std::array<std::reference_wrapper<int>, 3>>);
+    assert(&xs[1].get() == &points[1].x);
+
+    // the elements of a tuple are not contiguous, even with an accessor
+    std::tuple<int, int> t{7, 8};
+    auto tuple_refs = invoke_forall_span(std::identity{}, t);
+    assert(&tuple_refs[1].get() == &std::get<1>(t));
+}
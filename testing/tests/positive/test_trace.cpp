@@ -0,0 +1,80 @@
+#include "invoke_forall_trace.h"
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct recording_tracer {
+    std::vector<std::size_t> begins;
+    std::vector<std::size_t> ends;
+    std::vector<std::string> types;
+
+    void on_begin(const trace_event& event) {
+        begins.push_back(event.index);
+        std::string names;
+        for (auto name : event.arg_types) {
+            names += std::string(name) + ";";
+        }
+        types.push_back(names);
+    }
+
+    void on_end(const trace_event& event) {
+        ends.push_back(event.index);
+    }
+};
+
+constexpr bool test_constexpr() {
+
+    struct constexpr_tracer {
+        constexpr void on_begin(const trace_event&) {}
+        constexpr void on_end(const trace_event&) {}
+    } tracer;
+
+    auto res = invoke_forall_traced(tracer, std::plus<int>{},
+                                    std::array{1, 2}, 10);
+    return std::get<0>(res) == 11 && std::get<1>(res) == 12;
+}
+
+int main() {
+    static_assert(test_constexpr());
+
+    recording_tracer tracer;
+    auto res = invoke_forall_traced(
+        tracer,
+        [](auto a, int b) { return a + b; },
+        std::tuple{1, 2.5},
+        3
+    );
+
+    assert(std::get<0>(res) == 4);
+    assert(std::get<1>(res) == 5.5);
+    assert((tracer.begins == std::vector<std::size_t>{0, 1}));
+    assert((tracer.ends == std::vector<std::size_t>{0, 1}));
+    assert(tracer.types[0].find("int") != std::string::npos);
+    assert(tracer.types[1].find("double") != std::string::npos);
+
+    recording_tracer single;
+    assert(invoke_forall_traced(single, std::negate<int>{}, 5) == -5);
+    assert(single.begins.size() == 1);
+
+    std::ostringstream json;
+    {
+        chrome_trace_writer writer(json);
+        invoke_forall_traced(writer, [](int) {}, std::array{1, 2, 3});
+    }
+
+    std::string out = json.str();
+    assert(out.starts_with("{\"traceEvents\":["));
+    assert(out.find("\"invoke_at<2>\"") != std::string::npos);
+    assert(out.find("\"ph\":\"X\"") != std::string::npos);
+    assert(out.ends_with("]}\n"));
+
+    // an hour into a trace, still with nanosecond resolution
+    std::ostringstream micros;
+    detail::write_micros(micros, std::chrono::nanoseconds(3'600'000'000'042));
+    assert(micros.str() == "3600000000.042");
+}
@@ -16,7 +16,7 @@ echo_fail() {
 }
 
 test_negative() {
-    cp invoke_forall.h negative/
+    cp invoke_forall*.h negative/
 
     for file in negative/*.cpp; do
         echo -n "${file%.cpp}: "
@@ -29,11 +29,11 @@ test_negative() {
         fi
     done
 
-    rm negative/invoke_forall.h
+    rm negative/invoke_forall*.h
 }
 
 test_positive() {
-    cp invoke_forall.h positive/
+    cp invoke_forall*.h positive/
 
     for file in positive/*.cpp; do
         echo -n "${file%.cpp}: "
@@ -52,12 +52,12 @@ test_positive() {
         fi
     done
 
-    rm positive/invoke_forall.h
+    rm positive/invoke_forall*.h
 }
 
-cp ../invoke_forall.h .
+cp ../invoke_forall*.h .
 
 test_negative
 test_positive
 
-rm *.out invoke_forall.h
+rm *.out invoke_forall*.h